@@ -0,0 +1,104 @@
+/*
+ * AmgPreconditioner.h
+ *
+ *  Created on: 18.10.2026
+ */
+
+#ifndef AMGPRECONDITIONER_H_
+#define AMGPRECONDITIONER_H_
+
+#include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/vector.h>
+
+#include <vector>
+
+using namespace dealii;
+using namespace std;
+
+namespace femocs {
+
+/** @brief Algebraic multigrid preconditioner based on smoothed aggregation.
+ * Designed for the symmetric positive definite matrices of Laplace and heat equations,
+ * where it keeps the number of Conjugate Gradient iterations almost independent of the mesh size.
+ * One application of the preconditioner is a single V-cycle with symmetric Gauss-Seidel smoothing.
+ */
+class AmgPreconditioner {
+public:
+    AmgPreconditioner() {}
+
+    /** Build the multigrid hierarchy for the system matrix
+     * @param matrix     system matrix with Dirichlet boundary conditions already applied
+     * @param threshold  strength threshold of the connections between the dofs on the finest level
+     */
+    void initialize(const SparseMatrix<double>& matrix, const double threshold=0.08);
+
+    /** Apply the preconditioner, i.e approximate dst = A^-1 * src with one V-cycle */
+    void vmult(Vector<double>& dst, const Vector<double>& src) const;
+
+    /** Return the number of levels in the multigrid hierarchy */
+    int n_levels() const { return levels.size(); }
+
+    /** Return the ratio of non-zero entries in all the levels and in the finest level */
+    double operator_complexity() const;
+
+private:
+    static constexpr int max_levels = 12;          ///< max number of levels in the hierarchy
+    static constexpr int max_coarse_size = 500;    ///< size of matrix that is small enough to be solved directly
+    static constexpr int max_direct_size = 1000;   ///< max size of matrix that is allowed to be solved directly
+
+    /** Sparse matrix in compressed row storage format */
+    struct Csr {
+        int n_rows = 0;        ///< number of rows
+        int n_cols = 0;        ///< number of columns
+        vector<int> offsets;   ///< location of the first entry of each row in cols & vals
+        vector<int> cols;      ///< column indices of the non-zero entries
+        vector<double> vals;   ///< values of the non-zero entries
+
+        /** Calculate dst = this * src */
+        void vmult(vector<double>& dst, const vector<double>& src) const;
+
+        /** Return the transpose of the matrix */
+        Csr transpose() const;
+
+        /** Return the matrix product this * b */
+        Csr multiply(const Csr& b) const;
+    };
+
+    /** Data of a single level in the multigrid hierarchy */
+    struct Level {
+        Csr A;                    ///< system matrix
+        Csr P;                    ///< prolongation from the next coarser level to this level
+        Csr R;                    ///< restriction from this level to the next coarser level
+        vector<double> inv_diag;  ///< inverse of the diagonal of the system matrix
+        mutable vector<double> x; ///< solution vector
+        mutable vector<double> b; ///< right-hand-side vector
+        mutable vector<double> r; ///< residual vector
+    };
+
+    vector<Level> levels;           ///< multigrid hierarchy; first one is the finest level
+    vector<double> coarse_cholesky; ///< dense Cholesky factor of the coarsest matrix; empty if not factorized
+
+    /** Group the strongly connected dofs into aggregates and return the number of aggregates.
+     * The dofs without strong connections are not aggregated and get the aggregate index -1. */
+    int aggregate(const Csr& A, const vector<bool>& strong, vector<int>& aggregates) const;
+
+    /** Calculate the smoothed prolongation operator from the aggregates of the dofs */
+    Csr smoothed_prolongator(const Csr& A, const vector<bool>& strong,
+            const vector<int>& aggregates, const int n_aggregates) const;
+
+    /** Calculate the Cholesky factor of the coarsest matrix; return false if it failed */
+    bool factorize_coarse();
+
+    /** Solve the matrix equation on the coarsest level */
+    void solve_coarse() const;
+
+    /** Perform one forward or backward Gauss-Seidel sweep on the given level */
+    void smooth(const Level& level, const bool forward) const;
+
+    /** Perform V-cycle starting from the given level */
+    void vcycle(const int level) const;
+};
+
+} /* namespace femocs */
+
+#endif /* AMGPRECONDITIONER_H_ */
@@ -74,6 +74,17 @@ public:
     /** Store the atom coordinates from current run */
     void save_current_run_points();
 
+    /** Find the box that contains all the atoms that have moved more than min_distance
+     * since the last full iteration. If no atom has moved enough, the box will be empty.
+     * @return  false if current and previous iterations are not comparable */
+    bool get_moved_region(Point3& box_min, Point3& box_max, const double min_distance) const;
+
+    /** Obtain the displacement of i-th atom since the last full iteration */
+    Vec3 get_displacement(const int i) const {
+        require(i >= 0 && i < (int)previous_points.size(), "Invalid index: " + d2s(i));
+        return Vec3(get_point(i) - previous_points[i]);
+    }
+
     /** Obtain rms-distance the atoms have moved since the last full iteration.
      * BIG values (>10^308) indicate that current and previous iterations are not comparable. */
     double get_rmsd() const { return data.rms_distance; }
@@ -13,6 +13,7 @@
 #include "Config.h"
 #include "FileWriter.h"
 #include <memory>
+#include <float.h>
 
 using namespace std;
 namespace femocs {
@@ -78,7 +79,12 @@ protected:
 
     /** Get cut off radius that increases with distance from origin */
     double get_increasing_cutoff(const Point3 &point) const {
-        double cutoff = max(0.0, origin3d.distance(point) - radius);
+        return get_increasing_cutoff(origin3d.distance(point));
+    }
+
+    /** Get cut off radius that increases with given distance from the centre of coarsener */
+    double get_increasing_cutoff(const double distance) const {
+        double cutoff = max(0.0, distance - radius);
         cutoff = min( r0_max, A * pow(cutoff, exponential) + r0_min );
         return cutoff * cutoff;
     }
@@ -102,27 +108,41 @@ private:
     inline bool in_region(const Point3 &) const { return true; }
 };
 
-/** Class to coarsen surface outside one infinite vertical cylinder */
+/** Class to coarsen surface outside one or many infinite vertical cylinders */
 class FlatlandCoarsener: public Coarsener {
 public:
     FlatlandCoarsener();
     FlatlandCoarsener(const Point3 &origin, const double exponential, const double radius,
             const double A, const double r0_min=0, const double r0_max=1e20);
+    FlatlandCoarsener(const vector<Point3> &origins, const double exponential, const double radius,
+            const double A, const double r0_min=0, const double r0_max=1e20);
 
     /** Points OUTSIDE the region will be coarsened */
     void pick_cutoff(const Point3 &point) {
         if (in_region(point))
-            cutoff2 = get_increasing_cutoff(point);
+            cutoff2 = get_increasing_cutoff(get_min_distance(point));
         else
             cutoff2 = get_inf_cutoff();
     }
 
 private:
-    Point2 origin2d;
+    vector<Point3> origins3d;  ///< centres of the cylinders
+    vector<Point2> origins2d;  ///< projections of cylinder centres to x-y plane
 
-    /** Point outside infinitely high vertical cylinder? */
+    /** Point outside all the infinitely high vertical cylinders? */
     inline bool in_region(const Point3 &point) const {
-        return point.distance2(origin2d) > radius2;
+        for (const Point2 &origin : origins2d)
+            if (point.distance2(origin) <= radius2)
+                return false;
+        return true;
+    }
+
+    /** Distance from the point to the closest cylinder centre */
+    double get_min_distance(const Point3 &point) const {
+        double distance2 = DBL_MAX;
+        for (const Point3 &origin : origins3d)
+            distance2 = min(distance2, origin.distance2(point));
+        return sqrt(distance2);
     }
 };
 
@@ -255,8 +275,14 @@ public:
         return near;
     }
 
-    /** Generate coarseners for one nanotip system */
-    void generate(const Medium &medium, const double radius, const Config::CoarseFactor &cf, const double latconst);
+    /** Generate coarseners for system with one or many nanotips.
+     * @param n_roi  maximum number of regions of interest; 1 places single region to the middle of the system */
+    void generate(const Medium &medium, const double radius, const Config::CoarseFactor &cf,
+            const double latconst, const int n_roi=1);
+
+    /** Regenerate the coarseners with new coarsening factors
+     * while keeping the regions of interest that were located by generate */
+    void set_factors(const Config::CoarseFactor &cf, const double latconst);
 
     /** Get the distance between atoms on the edge of simulation cell */
     double get_r0_inf(const Medium::Sizes &s);
@@ -264,18 +290,32 @@ public:
     /** Radius of coarsening cylinder */
     double get_radius() const { return radius; }
 
+    /** Number of regions of interest */
+    int get_n_roi() const { return centres.size(); }
+
+    /** Check whether the point is inside the cone of any of the regions of interest */
     bool inside_interesting_region(const Point3& p) const;
 
-    Point3 centre;
+    Point3 centre;          ///< centre of the system at the average height of substrate
+    vector<Point3> centres; ///< bottom centres of the regions of interest
 private:
     double radius;
     double amplitude;
     double r0_cylinder;
+    vector<Point3> apexes;  ///< apexes of the regions of interest
     vector<shared_ptr<Coarsener>> coarseners;
 
     /** Get histogram for atom z-coordinates */
     void get_histogram(vector<int> &bins, vector<double> &bounds, const Medium& medium);
 
+    /** Get lateral height map where every square bin with given width holds
+     * the index of the highest atom inside the bin or -1 for an empty bin */
+    void get_histogram(vector<int> &highest, int &n_bins_x, int &n_bins_y,
+            const double bin_width, const Medium& medium);
+
+    /** Locate the apexes of up to n_roi separate protrusions from the local maxima of height map */
+    void get_apexes(vector<Point3> &apexes, const Medium& medium, const double z_bot, const int n_roi);
+
     /** Get the average z-coordinate of substrate atoms */
     double get_z_mean(const Medium& medium);
 
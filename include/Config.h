@@ -54,6 +54,7 @@ public:
         string infile;              ///< Path to the file with atom coordinates and types
         string mesh_file;           ///< Path to the triangular and tetrahedral mesh data
         string restart_file;        ///< Path to the restart file
+        string mesh_cache;          ///< Path to the directory of cached meshes; empty string turns caching off
     } path;
 
     /** User specific preferences */
@@ -86,6 +87,7 @@ public:
     struct Geometry {
         string mesh_quality;        ///< Minimum quality (maximum radius-edge ratio) of tetrahedra
         string element_volume;      ///< Maximum volume of tetrahedra
+        int n_mesh_slabs;           ///< Number of slabs where Delaunay triangulation is performed in parallel; 1 performs it serially
         int nnn;                    ///< Number of nearest neighbours for given crystal structure
         double latconst;            ///< Lattice constant
         double coordination_cutoff; ///< Cut-off distance for coordination analysis [same unit as latconst]
@@ -97,6 +99,9 @@ public:
         double bulk_height;         ///< Bulk substrate height [lattice constant]
         double radius;              ///< Radius of cylinder where surface atoms are not coarsened; 0 enables coarsening of all atoms
         double height;              ///< height of generated artificial nanotip in the units of radius
+        double morph_tol;           ///< max rms distance atoms are allowed to move so that the mesh is morphed instead of being regenerated; 0 turns morphing off
+        double remesh_buffer;       ///< width of the layer around moved atoms where the nodes of previous mesh are regenerated [latconst]; 0 turns incremental remeshing off
+        int n_roi;                  ///< max number of automatically detected regions of interest, i.e nanotips, where atoms are not coarsened
         /** Minimum rms distance between atoms from current and previous run so that their
          * movement is considered to be sufficiently big to recalculate electric field;
          * 0 turns the check off */
@@ -115,6 +120,8 @@ public:
     struct Field {
         double E0;             ///< Value of long range electric field (Active in case of Neumann anodeBC
         double ssor_param;     ///< Parameter for SSOR preconditioner in DealII
+        string precond;        ///< Preconditioner for Conjugate Gradient solver; ssor or amg
+        bool matrix_free;      ///< Apply Laplace operator cell by cell instead of assembling sparse matrix
         double cg_tolerance;   ///< Maximum allowed electric potential error
         int n_cg;              ///< Maximum number of Conjugate Gradient iterations in phi calculation
         double V0;             ///< Applied voltage at the anode (active in case of SC emission and Dirichlet anodeBC
@@ -131,8 +138,14 @@ public:
         int n_cg;                   ///< Max # Conjugate-Gradient iterations
         double cg_tolerance;        ///< Solution accuracy in Conjugate-Gradient solver
         double ssor_param;          ///< Parameter for SSOR preconditioner in DealII. Its fine tuning optimises calculation time.
+        string precond;             ///< Preconditioner for Conjugate Gradient solver; ssor or amg
+        double assemble_tol;        ///< Max temperature change since last assembly of heat conduction matrix before re-assembling it [K]
+        bool direct_solver;         ///< Solve current with sparse LU factorization that is reused until the mesh changes
         double delta_time;          ///< Timestep of time domain integration [sec]
         double dt_max;              ///< Maximum allowed timestep for heat convergence run
+        double dt_tolerance;        ///< Max estimated temperature error per adaptive heat time step [K]; 0 disables adaptivity
+        int n_newton;               ///< Max # Newton iterations in stationary mode
+        double t_error;             ///< Max temperature change in last Newton iteration in stationary mode [K]
         double tau;                 ///< Time constant in Berendsen thermostat
     } heating;
 
@@ -165,6 +178,10 @@ public:
         int r0_cylinder;    ///< minimum distance between atoms in nanotip outside the apex
         int r0_sphere;      ///< minimum distance between atoms in nanotip apex
         double exponential; ///< coarsening rate; min distance between coarsened atoms outside the warm region is d_min ~ pow(|r1-r2|, exponential)
+        int node_budget;    ///< target number of mesh nodes; 0 disables tuning by nodes
+        int elem_budget;    ///< target number of mesh elements; 0 disables tuning by elements
+        double time_budget; ///< target wall time of one full run [sec]; 0 disables tuning by time
+        double budget_tol;  ///< relative tolerance within which the budget must be met
     } cfactor;
 
 private:
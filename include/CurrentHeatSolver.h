@@ -32,7 +32,7 @@ public:
     virtual ~EmissionSolver() {}
 
     /** Solve the matrix equation using conjugate gradient method */
-    int solve() { return this->solve_cg(conf->n_cg, conf->cg_tolerance, conf->ssor_param); }
+    int solve() { return this->solve_cg(conf->n_cg, conf->cg_tolerance, conf->ssor_param, conf->precond == "amg"); }
 
     /** Set the pointers for obtaining external data */
     void set_dependencies(PhysicalQuantities *pq, const Config::Heating *conf) {
@@ -76,6 +76,13 @@ public:
      */
     void assemble();
 
+    /** Solve the matrix equation; as the matrix depends only on the mesh,
+     * the direct solver can reuse its factorization for every rhs on the same mesh */
+    int solve() {
+        if (this->conf->direct_solver) return this->solve_direct();
+        return EmissionSolver<dim>::solve();
+    }
+
 private:
     const HeatSolver<dim>* heat_solver;
     
@@ -100,12 +107,33 @@ public:
     HeatSolver(Triangulation<dim> *tria, const CurrentSolver<dim> *cs, vector<double>* bc_values);
 
     /** Assemble the matrix equation for temperature calculation
-     * using Crank-Nicolson or implicit Euler time integration method. */
-    void assemble(const double delta_time);
+     * using implicit Euler time integration method. */
+    void assemble(const double delta_time) { assemble_time_step(delta_time, 1.0); }
+
+    /** Advance the temperatures by delta_time using adaptive time steps.
+     * The local error of every step is estimated from the difference between
+     * implicit Euler and Crank-Nicolson solutions and the steps are adjusted to keep it below conf->dt_tolerance.
+     * @param delta_time  time interval to integrate [sec]
+     * @param dt_max      max allowed time step [sec]
+     * @param dt          initial time step on input, suggested time step for next interval on output [sec]
+     * @return total number of CG iterations; negative if some solve failed
+     */
+    int solve_adaptive(const double delta_time, const double dt_max, double& dt);
+
+    /** Make one Newton step towards the steady-state temperatures.
+     * The current potential and Nottingham heat are kept fixed during the step,
+     * the Jacobian takes into account the temperature dependence of thermal & electrical conductivity.
+     * @param t_change  max temperature change in the step [K]
+     * @return number of GMRES iterations; negative if linear solver failed
+     */
+    int solve_newton(double& t_change);
 
     /** Initialize data vectors and matrices */
     void setup_system();
 
+    /** Force re-assembly of mass and heat conduction matrices, e.g after moving the mesh vertices */
+    void reset_matrices() { matrices_assembled = false; }
+
 private:
     // TODO shouldn't it be temperature dependent?
     static constexpr double cu_rho_cp = 3.4496e-24;  ///< volumetric heat capacity of copper [J/(K*Ang^3)]
@@ -114,18 +142,48 @@ private:
     Vector<double> total_heat;       ///< integral Joule+Nottingham heat at dofs [Watt]
     const CurrentSolver<dim>* current_solver;
 
-    /**Calculates Joule heat for exporting*/
-    void calc_joule_heat();
+    SparseMatrix<double> mass_matrix;      ///< mass matrix multiplied with volumetric heat capacity
+    SparseMatrix<double> stiffness_matrix; ///< heat conduction matrix with lagged thermal conductivity
+    Vector<double> stiffness_temperature;  ///< temperatures that were used to assemble stiffness_matrix
+    bool matrices_assembled;               ///< are mass_matrix & stiffness_matrix valid for current mesh
+
+    /** Calculate Joule heat at dofs and, if requested, the dof volumes during the same sweep over the cells */
+    void calc_joule_heat(const bool calc_volumes=false);
+
+    /** Assemble heat conduction matrix with thermal conductivities at the current temperatures */
+    void assemble_stiffness();
 
     typedef typename DealSolver<dim>::LinearSystem LinearSystem;
     typedef typename DealSolver<dim>::ScratchData ScratchData;
     typedef typename DealSolver<dim>::CopyData CopyData;
 
+    /** Data for copying the Joule heat & dof volumes of a cell into global vectors */
+    struct JouleCopyData {
+        Vector<double> joule_heat;
+        Vector<double> volume;
+        vector<unsigned int> dof_indices;
+        JouleCopyData(const unsigned dofs_per_cell);
+    };
+
+    /** Calculate the Joule heat & dof volumes contributions of a cell */
+    void calc_joule_heat_local_cell(const typename DoFHandler<dim>::active_cell_iterator &cell,
+            ScratchData &scratch_data, JouleCopyData &copy_data, const bool calc_volumes) const;
+
+    /** Add the Joule heat & dof volumes contributions of a cell to global vectors */
+    // Only one instance of this function should be running at a time!
+    void copy_joule_heat(const JouleCopyData &copy_data, const bool calc_volumes);
+
+    /** Assemble the matrix equation for the temperatures after delta_time using theta-method:
+     * (C/dt * M + theta * K) * T = (C/dt * M - (1-theta) * K) * T_prev + Joule heat + Nottingham heat.
+     * theta=1 corresponds to implicit Euler, theta=0.5 to Crank-Nicolson method. */
+    void assemble_time_step(const double delta_time, const double theta);
+
     /** @brief assemble the matrix equation for temperature calculation using Crank-Nicolson time integration method
      * Calculate sparse matrix elements and right-hand-side vector
      * according to the time dependent heat equation weak formulation and to the boundary conditions.
+     * Heat sources are evaluated at the previous temperatures.
      */
-    void assemble_crank_nicolson(const double delta_time);
+    void assemble_crank_nicolson(const double delta_time) { assemble_time_step(delta_time, 0.5); }
 
     /** @brief assemble the matrix equation for temperature calculation using implicit Euler time integration method
      * Calculate sparse matrix elements and right-hand-side vector
@@ -133,7 +191,11 @@ private:
      */
     void assemble_euler_implicit(const double delta_time);
 
-    /** Calculate the contribution of one cell into global matrix and rhs vector */
+    /** Calculate the contribution of one cell into the Jacobian and right-hand-side of Newton iteration */
+    void assemble_newton_local_cell(const typename DoFHandler<dim>::active_cell_iterator &cell,
+            ScratchData &scratch_data, CopyData &copy_data) const;
+
+    /** Calculate the contribution of one cell into global heat conduction matrix */
     void assemble_local_cell(const typename DoFHandler<dim>::active_cell_iterator &cell,
             ScratchData &scratch_data, CopyData &copy_data) const;
 
@@ -161,6 +223,9 @@ public:
     /** Setup current and heat solvers */
     void setup(const double temperature);
 
+    /** Move the vertices of the mesh; as the geometry changes, the heat matrices are re-assembled */
+    bool update_vertices(const vector<Point<dim>>& vertices, const vector<CellData<dim>>& cells);
+
     /** Obtain number of degrees of freedom in solver */
     int size() const { return heat.size(); }
 
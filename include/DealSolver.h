@@ -10,12 +10,16 @@
 
 #include <deal.II/grid/grid_reordering.h>
 #include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/sparse_direct.h>
+#include <deal.II/lac/solver_control.h>
+#include <deal.II/lac/vector.h>
 #include <deal.II/hp/fe_values.h>
 
 #include <fstream>
 #include "Globals.h"
 #include "Medium.h"
 #include "FileWriter.h"
+#include "AmgPreconditioner.h"
 
 using namespace dealii;
 using namespace std;
@@ -27,6 +31,79 @@ template<int dim> class CurrentHeatSolver;
 template<int dim> class CurrentSolver;
 template<int dim> class HeatSolver;
 
+/** @brief Geometry data of the cells of the mesh in the quadrature points.
+ * For linear elements the real-space shape function values & gradients follow from
+ * the reference ones and from the inverse Jacobian of the cell, therefore storing
+ * JxW and inverse Jacobians per quadrature point is enough to avoid re-initializing FEValues.
+ */
+template<int dim>
+class CellGeometry {
+public:
+    CellGeometry() : n_cells(0), n_q_points(0), n_dofs(0) {}
+
+    /** Calculate the geometry data of all the active cells of dof handler */
+    void initialize(const DoFHandler<dim>& dof_handler, const Quadrature<dim>& quadrature);
+
+    /** Release the memory used by the geometry data */
+    void clear();
+
+    /** Check whether the geometry data has been calculated */
+    bool empty() const { return n_cells == 0; }
+
+    /** Return the number of quadrature points per cell */
+    unsigned int n_quadrature_points() const { return n_q_points; }
+
+    /** Return the number of dofs per cell */
+    unsigned int dofs_per_cell() const { return n_dofs; }
+
+    /** @brief Shape function values & gradients of a cell obtained from the geometry data.
+     * Has the same interface as FEValues, but reinit costs only few multiplications per gradient.
+     * Every thread must use its own instance. */
+    class Values {
+    public:
+        Values(const CellGeometry<dim>& geometry);
+
+        /** Select the cell with given active cell index; calculate the gradients only if requested */
+        void reinit(const unsigned int cell_index, const bool with_gradients=true);
+
+        /** Jacobian determinant times quadrature weight in q-th quadrature point */
+        double JxW(const unsigned int q) const { return geometry->jxw[offset + q]; }
+
+        /** Value of i-th shape function in q-th quadrature point */
+        double shape_value(const unsigned int i, const unsigned int q) const {
+            return geometry->shape_values[q * geometry->n_dofs + i];
+        }
+
+        /** Gradient of i-th shape function in q-th quadrature point */
+        const Tensor<1,dim>& shape_grad(const unsigned int i, const unsigned int q) const {
+            return shape_grads[q * geometry->n_dofs + i];
+        }
+
+        /** Values of finite element function in the quadrature points of the cell */
+        void get_function_values(const Vector<double>& fe_function, vector<double>& values) const;
+
+        /** Gradients of finite element function in the quadrature points of the cell */
+        void get_function_gradients(const Vector<double>& fe_function, vector<Tensor<1,dim>>& gradients) const;
+
+    private:
+        const CellGeometry<dim>* geometry;  ///< geometry data of all the cells
+        unsigned int cell;                  ///< index of current cell
+        unsigned int offset;                ///< location of the data of first quadrature point of the cell
+        vector<Tensor<1,dim>> shape_grads;  ///< real-space shape function gradients of the cell
+    };
+
+private:
+    unsigned int n_cells;     ///< number of cells whose data is stored
+    unsigned int n_q_points;  ///< number of quadrature points per cell
+    unsigned int n_dofs;      ///< number of dofs per cell
+
+    vector<double> shape_values;          ///< shape function values in quadrature points; same for all cells
+    vector<Tensor<1,dim>> ref_grads;      ///< shape function gradients in the reference cell
+    vector<double> jxw;                   ///< JxW per cell and quadrature point
+    vector<Tensor<2,dim>> inv_jacobians;  ///< inverse Jacobians per cell and quadrature point
+    vector<types::global_dof_index> dof_indices;  ///< dof indices per cell
+};
+
 /** @brief General class to implement FEM solver in Deal.II
  */
 template<int dim>
@@ -102,6 +179,21 @@ public:
      */
     bool import_mesh(vector<Point<dim>> vertices, vector<CellData<dim>> cells);
 
+    /**
+     * imports mesh from the data where unused vertices are already removed,
+     * cells are positively oriented and their vertices are in Deal.II order;
+     * therefore no clean-up on vertices and cells is performed
+     * @return true if success, otherwise false
+     */
+    bool import_compact_mesh(const vector<Point<dim>>& vertices, const vector<CellData<dim>>& cells);
+
+    /**
+     * moves the vertices of previously imported mesh without altering its topology,
+     * therefore the dof numbering and sparsity pattern remain valid
+     * @return true if success, otherwise false
+     */
+    bool update_vertices(const vector<Point<dim>>& vertices, const vector<CellData<dim>>& cells);
+
     /** Print the statistics about the mesh and # degrees of freedom */
     friend ostream& operator <<(ostream &os, const DealSolver<dim>& d) {
         os << "#elems=" << d.tria->n_active_cells()
@@ -141,6 +233,13 @@ protected:
     Vector<double> system_rhs;               ///< right-hand-side of the matrix equation
     Vector<double> solution;                 ///< resulting solution in the mesh nodes
 
+    SparseDirectUMFPACK direct_solver;       ///< LU factorization of system matrix
+    bool factorized;                         ///< is direct_solver valid for current mesh and dofs
+
+    AmgPreconditioner amg;                   ///< multigrid hierarchy of system matrix
+    bool amg_initialized;                    ///< is amg valid for current mesh and dofs
+    int amg_n_steps;                         ///< nr of iterations in the first solve after building amg
+
     vector<double> dof_volume;               ///< integral of the shape functions
     vector<unsigned> vertex2dof;             ///< map of vertex to dof indices
     vector<unsigned> vertex2cell;            ///< map of vertex to cell indices
@@ -158,9 +257,8 @@ protected:
 
     /** Data for parallel local matrix & rhs assembly */
     struct ScratchData {
-        FEValues<dim> fe_values;
-        ScratchData(const FiniteElement<dim> &fe, const Quadrature<dim> &quadrature, const UpdateFlags flags);
-        ScratchData(const ScratchData &scratch_data);
+        typename CellGeometry<dim>::Values cell_values;
+        ScratchData(const CellGeometry<dim> &geometry);
     };
 
     /** Data for coping local matrix & rhs into global one during parallel assembly */
@@ -172,10 +270,46 @@ protected:
         CopyData(const unsigned dofs_per_cell, const unsigned n_q_points);
     };
 
+    /** Boundary face together with the cell it belongs to and its pre-computed integration data */
+    struct BoundaryFace {
+        typename DoFHandler<dim>::active_cell_iterator cell;
+        unsigned int face;   ///< index of the face in the cell
+        unsigned int index;  ///< index of the face among the boundary faces with the same boundary id
+        Point<dim> centroid; ///< centroid of the face
+        vector<types::global_dof_index> dof_indices; ///< dofs of the cell; empty if dofs are not distributed
+        vector<double> shape_integrals;  ///< integrals of cell shape functions over the face
+    };
+
+    /** Faces on the boundary of mesh grouped by boundary id; built on demand once per mesh */
+    mutable map<int, vector<BoundaryFace>> boundary_faces;
+
+    /** JxW & inverse Jacobians of the cells; built on demand once per mesh */
+    mutable CellGeometry<dim> cell_geometry;
+
     /** Copy the matrix & rhs vector contribution of a cell into global matrix & rhs vector */
     // Only one instance of this function should be running at a time!
     void copy_global_cell(const CopyData &copy_data, LinearSystem &system) const;
 
+    /** Return the boundary faces with given boundary id in the order of cells.
+     * The faces with their integration data are collected during the first call after mesh or dof change. */
+    const vector<BoundaryFace>& get_boundary_faces(const int bid) const;
+
+    /** Return the geometry data of the cells in the quadrature points.
+     * The data is calculated during the first call after mesh or dof change. */
+    const CellGeometry<dim>& get_cell_geometry() const;
+
+    /** Invalidate the data that depends on the mesh geometry or dof numbering,
+     * incl the matrix factorization and multigrid hierarchy */
+    void clear_mesh_cache();
+
+    /** Calculate the integrals of shape functions over a cell */
+    void calc_dof_volumes_local_cell(const typename DoFHandler<dim>::active_cell_iterator &cell,
+            ScratchData &scratch_data, CopyData &copy_data) const;
+
+    /** Add the integrals of shape functions over a cell to the dof volumes */
+    // Only one instance of this function should be running at a time!
+    void copy_dof_volumes(const CopyData &copy_data);
+
     /** Helper function for the public shape_funs */
     vector<double> shape_funs(const Point<dim> &p, const int cell_index, Mapping<dim,dim>& mapping) const;
 
@@ -186,11 +320,38 @@ protected:
      * @param n_steps     maximum number of iterations allowed
      * @param tolerance   tolerance of the solution
      * @param ssor_param  parameter to SSOR preconditioner. Its fine tuning optimises calculation time
+     * @param use_amg     use algebraic multigrid instead of SSOR preconditioner;
+     *                    the hierarchy is kept between the calls until it becomes inefficient
      */
-    int solve_cg(const int n_steps, const double tolerance, const double ssor_param);
-
-    /** Set up dynamic sparsity pattern for calculations */
-    void setup_system();
+    int solve_cg(const int n_steps, const double tolerance, const double ssor_param, const bool use_amg=false);
+
+    /** Solve the matrix equation with given iterative solver and preconditioner.
+     * In case of multigrid, the hierarchy is built or reused and, if the reused one failed, rebuilt.
+     * @return  nr of iterations; negative, if the solution didn't converge */
+    template<typename Solver>
+    int solve_iterative(Solver& solver, const SolverControl& solver_control, const double ssor_param, const bool use_amg);
+
+    /** Build the multigrid hierarchy of system matrix, unless the one built for an earlier matrix
+     * on the same mesh is still in use; return true if the hierarchy was reused */
+    bool init_amg();
+
+    /** Mark the reused multigrid hierarchy outdated if it needed much more iterations
+     * than right after building it, so that the next solve rebuilds it */
+    void check_amg(const int n_steps, const bool reused);
+
+    /** Solve the matrix equation with sparse LU factorization.
+     * The factorization is calculated during the first call after mesh or dof change and reused afterwards,
+     * therefore the system matrix must not change between the calls, only the rhs vector may do so.
+     * @return 0 on success, -1 if factorization failed */
+    int solve_direct();
+
+    /** Solve the non-symmetric matrix equation using restarted GMRES method.
+     * The parameters are the same as in solve_cg. */
+    int solve_gmres(const int n_steps, const double tolerance, const double ssor_param, const bool use_amg=false);
+
+    /** Distribute dofs and set up sparsity pattern for calculations;
+     * matrix-free solvers need no sparsity pattern nor system matrix */
+    void setup_system(const bool with_matrix=true);
 
     /** Modify the right-hand-side vector of the matrix equation */
     void assemble_rhs(const int bid);
@@ -31,8 +31,9 @@ public:
      * @param force  omit the control for last write time
      * @param update update last write time variable after successful write
      * @param append force appending to already excisting file
+     * @return 0 if the file was written or writing was not needed, 1 if writing failed
      */
-    void write(const string &file, unsigned int flags=0);
+    int write(const string &file, unsigned int flags=0);
 
     /** Size of the data vector */
     virtual int size() const { return 0; }
@@ -57,6 +58,7 @@ protected:
     virtual void write_bin(ofstream &out) const;
     virtual void write_dat(ofstream &out) const;
     virtual void write_ckx(ofstream &out) const;
+    virtual void write_fmesh(ofstream &out) const;
 
     /** Label for restart data */
     virtual string get_restart_label() const;
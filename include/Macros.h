@@ -13,6 +13,7 @@
 #include <string>
 #include <vector>
 #include <cmath>
+#include <cstdint>
 #include <typeinfo>
 
 using namespace std;
@@ -85,6 +86,10 @@ vector<bool> vector_less_equal(const vector<int> *v, const int s);
 /** Return sorting indexes for one vector */
 vector<int> get_sort_indices(const vector<int> &v, const string& direction="up");
 
+/** Return the distance of a point along 3D Hilbert curve with 21-bit resolution per coordinate.
+ * The coordinates must be scaled into the range [0, 1]. */
+uint64_t hilbert_index(const double x, const double y, const double z);
+
 /** Sum of the elements in vector */
 int vector_sum(const vector<bool> &v);
 int vector_sum(const vector<int> &v);
@@ -8,6 +8,8 @@
 #ifndef LAPLACE_H_
 #define LAPLACE_H_
 
+#include <deal.II/matrix_free/matrix_free.h>
+
 #include "DealSolver.h"
 #include "Config.h"
 #include "InterpolatorCells.h"
@@ -16,6 +18,53 @@ namespace femocs {
 using namespace dealii;
 using namespace std;
 
+/** @brief Matrix-free Laplace operator that evaluates the cell integrals on the fly.
+ * The rows of constrained (Dirichlet) dofs act as identity and their columns are eliminated,
+ * i.e the operator equals to the assembled matrix with applied Dirichlet BCs.
+ * Cells are processed in batches, so that cell kernels get vectorized over the cells.
+ */
+template<int dim, int fe_degree>
+class LaplaceOperator {
+public:
+    LaplaceOperator() {}
+
+    /** Pre-calculate the geometry data of the cells */
+    void initialize(const DoFHandler<dim>& dof_handler);
+
+    /** Store the dofs whose values are fixed by Dirichlet BCs */
+    void set_constrained_dofs(const map<types::global_dof_index, double>& boundary_values);
+
+    /** Calculate dst = A * src, where the constrained columns of A are eliminated */
+    void vmult(Vector<double>& dst, const Vector<double>& src) const;
+
+    /** Operator is symmetric, therefore Tvmult equals to vmult */
+    void Tvmult(Vector<double>& dst, const Vector<double>& src) const { vmult(dst, src); }
+
+    /** Calculate dst = A * src without eliminating the constrained dofs */
+    void apply(Vector<double>& dst, const Vector<double>& src) const;
+
+    /** Calculate the inverse of the operator diagonal */
+    void calc_inverse_diagonal(Vector<double>& inverse_diagonal) const;
+
+    /** Return the number of rows and columns of operator */
+    types::global_dof_index m() const { return n_dofs; }
+    types::global_dof_index n() const { return n_dofs; }
+
+private:
+    MatrixFree<dim, double> data;                   ///< cell geometries & dof mappings
+    types::global_dof_index n_dofs = 0;             ///< number of degrees of freedom
+    vector<types::global_dof_index> constrained_dofs; ///< dofs fixed by Dirichlet BCs
+    mutable Vector<double> free_src;                ///< source vector with zeroed constrained dofs
+
+    /** Apply operator on the given range of cell batches */
+    void local_apply(const MatrixFree<dim, double>& data, Vector<double>& dst,
+            const Vector<double>& src, const pair<unsigned int, unsigned int>& cell_range) const;
+
+    /** Calculate the diagonal of operator on the given range of cell batches */
+    void local_diagonal(const MatrixFree<dim, double>& data, Vector<double>& dst,
+            const unsigned int& dummy, const pair<unsigned int, unsigned int>& cell_range) const;
+};
+
 /** @brief Class to solve Laplace equation in 2D or 3D
  * It is inspired by the step-3 of Deal.II tutorial
  * https://www.dealii.org/8.5.0/doxygen/deal.II/step_3.html
@@ -47,10 +96,11 @@ public:
     void export_charge_dens(vector<double> &charge_dens) const;
 
     /** Run Conjugate-Gradient solver to solve matrix equation */
-    int solve() { return this->solve_cg(conf->n_cg, conf->cg_tolerance, conf->ssor_param); }
+    int solve();
 
-    /** Setup system for solving Poisson equation */
-    void setup(const double field, const double potential);
+    /** Setup system for solving Poisson equation;
+     * without full setup the dof numbering and sparsity pattern of previous mesh are kept */
+    void setup(const double field, const double potential, const bool full_setup=true);
 
     /** Assemble the matrix equation to solve Laplace or Poisson equation
      * by appling Neumann BC (constant field) or Dirichlet BC (constant potential) on top of simubox */
@@ -64,6 +114,11 @@ private:
     double applied_potential; ///< applied potential on top of simubox
     Vector<double> charge_density;   ///< charge density at dofs [e/Angstrom^3]
 
+    LaplaceOperator<dim, DealSolver<dim>::shape_degree> laplace_operator; ///< operator for matrix-free solver
+
+    static constexpr unsigned int chebyshev_degree = 4;  ///< degree of Chebyshev preconditioner in matrix-free solver
+    static constexpr double chebyshev_range = 20.0;      ///< ratio of max and min eigenvalue Chebyshev preconditioner targets
+
     typedef typename DealSolver<dim>::LinearSystem LinearSystem;
     typedef typename DealSolver<dim>::ScratchData ScratchData;
     typedef typename DealSolver<dim>::CopyData CopyData;
@@ -86,6 +141,12 @@ private:
     /** Assemble left-hand-side of matrix equation in a parallel manner */
     void assemble_parallel();
 
+    /** Apply Dirichlet BCs to the right-hand-side and solution vectors of matrix-free system */
+    void apply_dirichlet_matrix_free();
+
+    /** Solve the equation with matrix-free operator and Chebyshev-Jacobi preconditioned CG */
+    int solve_matrix_free();
+
     /** Calculate the contribution of one cell into global matrix and rhs vector */
     void assemble_local_cell(const typename DoFHandler<dim>::active_cell_iterator &cell,
             ScratchData &scratch_data, CopyData &copy_data) const;
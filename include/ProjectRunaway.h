@@ -65,16 +65,28 @@ protected:
     bool fail;                  ///< If some process failed
     double t0;                  ///< CPU timer
     bool mesh_changed;          ///< True if new mesh has been created
+    bool mesh_morphed;          ///< True if the nodes of existing mesh were moved instead of creating a new mesh
     bool first_run;             ///< True only as long as there is no full run
     double last_heat_time;      ///< Last time heat was updated
+    double heat_dt;             ///< Sub-step of heat solver suggested by adaptive time stepping [fs]
     int last_restart_ts;        ///< Last time step reset file was written
     int restart_cntr;           ///< How many restart files have been written
+    int n_coarse_points;        ///< Nr of coarse surface points in last generated mesh
+    Config::CoarseFactor cfactor; ///< Coarsening factors in use; differ from configured ones if tuned to meet budget
+    double nodes_per_point;     ///< Ratio of mesh nodes and coarse surface points in last generated mesh
+    double elems_per_point;     ///< Ratio of mesh elements and coarse surface points in last generated mesh
+    double time_per_node;       ///< Wall time of last full run with new mesh per mesh node [sec]
+    int n_bulk_own;             ///< Nr of bulk generators in last generated mesh that were not reused from earlier mesh
+    int n_vacuum_own;           ///< Nr of vacuum generators in last generated mesh that were not reused from earlier mesh
+    Config::CoarseFactor mesh_cfactor; ///< Coarsening factors of last generated mesh
+    vector<Point3> mesh_roi;    ///< Centres of the regions of interest of last generated mesh
 
     Interpolator vacuum_interpolator;  ///< data & operations for interpolating field & potential in vacuum
     Interpolator bulk_interpolator;    ///< data & operations for interpolating current density & temperature in bulk
 
     Surface dense_surf;       ///< non-coarsened surface atoms
     Surface extended_surf;    ///< atoms added for the surface atoms
+    vector<int> surf_node_ids; ///< indices of imported atoms that correspond to the surface nodes of mesh; -1 for generated nodes
 
     FieldReader fields;       ///< fields & potentials on surface atoms
     HeatReader  temperatures; ///< temperatures & current densities on bulk atoms
@@ -83,6 +95,7 @@ protected:
     FieldReader surface_fields;       ///< fields on surface hex face centroids
     HeatReader  surface_temperatures; ///< temperatures & current densities on surface hex face centroids
     HeatReader  heat_transfer;        ///< temperatures on new mesh dofs interpolated on old solution space
+    FieldReader field_transfer;       ///< potentials on new mesh dofs interpolated on old solution space
 
     PhysicalQuantities phys_quantities; ///< quantities used in heat calculations
     PoissonSolver<3> poisson_solver;    ///< Poisson equation solver
@@ -93,6 +106,13 @@ protected:
     /** Generate bulk and vacuum meshes using the imported atomistic data */
     int generate_mesh();
 
+    /** Read the mesh from mesh_file; to speed up the repeated runs,
+     * the mesh is cached into the same folder in native binary format */
+    int read_mesh_file();
+
+    /** Move the nodes of existing mesh according to the atom displacements */
+    int morph_mesh();
+
     /** Pass mesh to all the objects that need it
      * and transfer temperature from previous iteration to the new mesh */
     int prepare_solvers();
@@ -106,6 +126,16 @@ protected:
     /** Solve transient heat and continuity equations */
     int solve_heat(double T_ambient, double delta_time, bool full_run, int& ccg, int& hcg);
 
+    /** Find the steady-state temperatures by alternating the emission, current solve
+     * and Newton step for the temperatures until the temperature change drops below t_error */
+    int solve_stationary_heat(bool full_run, int& ccg, int& hcg);
+
+    /** Calculate the emission and with its BCs the current density */
+    int solve_current(bool full_run, int& ccg);
+
+    /** Transfer the current densities and temperatures from the solver to the bulk interpolator */
+    void extract_heat();
+
     /** Using the electric field, calculate atomistic charge together with Lorenz and/or Coulomb force */
     int solve_force();
 
@@ -122,6 +152,35 @@ private:
     /** Generate boundary nodes for mesh */
     int generate_boundary_nodes(Surface& bulk, Surface& coarse_surf, Surface& vacuum);
 
+    /** Generate the mesh generators and out of them the new mesh or read it from cache
+     * @param n_bulk    nr of bulk generators that were not reused from previous mesh
+     * @param n_vacuum  nr of vacuum generators that were not reused from previous mesh
+     * @return  0 on success */
+    int generate_new_mesh(int& n_bulk, int& n_vacuum);
+
+    /** Convert the mesh node, element and wall time budgets into the target number of coarse
+     * surface points by using the statistics of previous mesh; 0 means no budget is active.
+     * Wall time budget is active only after the first full run, as its cost is measured there. */
+    int get_coarse_budget() const;
+
+    /** Calibrate the node and element budgets with the very first mesh
+     * and check whether it missed the budget by more than the tolerance */
+    bool budget_missed();
+
+    /** Return the path to the cached mesh with given mesh generators; the file name is the hash
+     * of quantised generator coordinates and the parameters that affect the mesh generation */
+    string get_mesh_cache_file(const Surface& bulk, const Surface& coarse_surf, const Surface& vacuum) const;
+
+    /** Write the new mesh into the cache file via temporary file, so that the cache never contains
+     * partially written mesh; return 0 on success */
+    int write_mesh_cache(const string& cache_file) const;
+
+    /** Append the nodes of previous mesh that are far from the moved atoms and from the coarse
+     * surface points, that are missing in previous mesh, to the mesh generators.
+     * This way Tetgen does not need to refine again the regions where nothing changed.
+     * Nothing is reused if the coarsening factors or the regions of interest have changed. */
+    void reuse_mesh_nodes(Surface& bulk, const Surface& coarse_surf, Surface& vacuum);
+
     /** Transfer mesh from Tetgen into Deal.II */
     int import_mesh();
 
@@ -150,6 +150,9 @@ public:
     /** In addition to regular interpolation, pre-calculate also field norms */
     void calc_interpolation();
 
+    /** Interpolate potentials on the mesh DOFs of the FEM solver to be used as an initial guess */
+    void interpolate_dofs(PoissonSolver<3>& solver);
+
     /** Return electric field in i-th interpolation point */
     Vec3 get_elfield(const int i) const {
         require(i >= 0 && i < size(), "Invalid index: " + d2s(i));
@@ -206,7 +209,8 @@ public:
 
     HeatReader(Interpolator* i);
 
-    /** Interpolate and export solution on the mesh DOFs of the FEM solver */
+    /** Interpolate and export solution on the mesh DOFs of the FEM solver.
+     * Temperatures are imported into heat solver, potentials into current solver as an initial guess. */
     void interpolate_dofs(CurrentHeatSolver<3>& solver, const TetgenMesh* mesh);
 
     /** Compute data that Berendsen thermostat requires for re-using old solution */
@@ -242,6 +246,7 @@ private:
     vector<vector<int>> tet2atoms;
     vector<double> fem_temp;
     vector<double> temperatures;
+    vector<double> potentials;
 
     /** Transfer velocities from Parcas units to fm / fs */
     void calc_SI_velocities(vector<Vec3>& velocities, const int n_atoms, const Vec3& parcas2si, double* x1);
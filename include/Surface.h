@@ -36,9 +36,24 @@ public:
     /** Pick suitable method for extending Surface */
     void extend(Surface& extension, const Config& conf);
 
-    /** Generate nodal data that can be used as mesh generators */
+    /** Generate nodal data that can be used as mesh generators
+     * using the coarsening factors that may differ from the ones in conf */
     int generate_boundary_nodes(Surface& bulk, Surface& coarse_surf, Surface& vacuum,
-            const Surface& extended_surf, const Config& conf, const bool first_time);
+            const Surface& extended_surf, const Config& conf, const Config::CoarseFactor& cf,
+            const bool first_time);
+
+    /** @brief Tune the coarsening amplitude and exponent to meet the target number of coarse surface points.
+     * The tuning is done by repeatedly coarsening the surface without calling mesh generator.
+     * The amplitude is searched first; if the target remains out of reach, the exponent is searched.
+     * As every trial costs a full clean of the surface, the total number of trials is capped.
+     * The regions of interest are located only once and shared between the trials.
+     * @return  tuned coarsening factors; coarseners are generated with them on exit
+     */
+    Config::CoarseFactor tune_coarseners(const Surface& extended_surf, const Config& conf,
+            const int n_target);
+
+    /** Bottom centres of the regions of interest of coarseners */
+    const vector<Point3>& get_roi() const { return coarseners.centres; }
 
     /** Remove the atoms that are too far from surface faces */
     void clean_by_triangles(Interpolator& interpolator, const TetgenMesh* mesh, const double r_cut);
@@ -65,8 +80,16 @@ private:
     /** Clean the surface from atoms that are too close to each other */
     void clean(Surface& surface);
 
+    /** Number of coarse surface points that given coarsening factors would produce
+     * for the coarseners, whose regions of interest are already located */
+    int count_coarse_points(const Surface& extended_surf, const vector<bool>& in_roi,
+            const Config& conf, const Config::CoarseFactor& cf);
+
+    /** Mark the atoms that are inside the regions of interest of coarseners */
+    void mark_roi(vector<bool>& in_roi) const;
+
     /** Clean atoms inside the region of interest and add the result to the provided surface */
-    void add_cleaned_roi_to(Surface& surface);
+    void add_cleaned_roi_to(Surface& surface, const vector<bool>& in_roi);
 
     /** Smoothen the atoms inside the cylinder */
     void smoothen(const double radius, const double smooth_factor, const double r_cut);
@@ -1394,6 +1394,7 @@ public:
   static int snextpivot[6];
 
   void inittables();
+  static void filltables();
 
   // Primitives for tetrahedra.
   inline tetrahedron encode(triface& t);
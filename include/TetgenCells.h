@@ -132,6 +132,9 @@ public:
     /** Get number of cell markers */
     int get_n_markers() const { return markers.size(); };
 
+    /** Replace all the markers with the given ones */
+    void store_markers(const vector<int>& m) { markers = m; }
+
     /** Return i-th marker */
     int get_marker(const int i) const {
         require(i >= 0 && i < static_cast<int>(get_n_markers()), "Invalid index: " + d2s(i));
@@ -153,6 +156,9 @@ public:
     /** Return pointer to markers */
     const vector<int>* get_markers() const { return &markers; }
 
+    /** Return the memory in bytes that is occupied by the data outside the Tetgen buffers */
+    virtual size_t memory_usage() const { return markers.capacity() * sizeof(int); }
+
     /** Assign m-th marker */
     void set_marker(const int node, const int m) {
         require(node >= 0 && node < static_cast<int>(get_n_markers()), "Invalid index: " + d2s(node));
@@ -171,6 +177,30 @@ public:
                 }
     }
 
+    /** Calculate the neighbourlist for the nodes in compressed sparse row format;
+     * the neighbours of node i are in nbors[offsets[i]] ... nbors[offsets[i+1]-1].
+     * Like in the vector-of-vectors version, the neighbour appears once per shared cell. */
+    void calc_nborlist(vector<int>& offsets, vector<int>& nbors) const {
+        const int n_nodes = get_n_nodes();
+        const int n_cells = size();
+
+        offsets = vector<int>(n_nodes + 1, 0);
+        for (int i = 0; i < n_cells; ++i)
+            for (int node : get_cell(i))
+                offsets[node + 1] += dim - 1;
+        for (int i = 0; i < n_nodes; ++i)
+            offsets[i + 1] += offsets[i];
+
+        vector<int> cursor(offsets.begin(), offsets.end() - 1);
+        nbors.resize(offsets[n_nodes]);
+        for (int i = 0; i < n_cells; ++i) {
+            SimpleCell<dim> cell = get_cell(i);
+            for (int n1 : cell)
+                for (int n2 : cell)
+                    if (n1 != n2) nbors[cursor[n1]++] = n2;
+        }
+    }
+
     /** Accessor for accessing i-th cell */
     SimpleCell<dim> operator [](const size_t i) const { return get_cell(i); }
 
@@ -476,6 +506,12 @@ public:
     /** Calculate the norms and areas for all the triangles */
     void calc_appendices();
 
+    /** Return the memory in bytes that is occupied by the data outside the Tetgen buffers */
+    size_t memory_usage() const {
+        return TetgenCells<3>::memory_usage() + areas.capacity() * sizeof(double)
+                + norms.capacity() * sizeof(Vec3) + centroids.capacity() * sizeof(Point3);
+    }
+
     /** Struct holding statistics about triangles */
     struct Stat {
         double edgemin;    ///< min edge length
@@ -528,8 +564,8 @@ public:
 
     /** Return indices of all triangles that are connected to i-th tetrahedron*/
     vector<int> to_tris(const int i) const {
-        require(i >= 0 && i < (int)map2tris.size(), "Invalid index: " + d2s(i));
-        return map2tris[i];
+        require(i >= 0 && i < (int)map2tris_offsets.size() - 1, "Invalid index: " + d2s(i));
+        return vector<int>(map2tris.begin() + map2tris_offsets[i], map2tris.begin() + map2tris_offsets[i+1]);
     }
 
     /** Return indices of all hexahedra that are connected to i-th tetrahedron*/
@@ -542,11 +578,18 @@ public:
     /** Calculate statistics about tetrahedra */
     void calc_statistics();
 
-    /** Store data for mapping tetrahedron to triangles */
-    void store_map(const vector<vector<int>>& map) {
+    /** Store data for mapping tetrahedron to triangles in compressed sparse row format */
+    void store_map(const vector<int>& offsets, const vector<int>& map) {
+        map2tris_offsets = offsets;
         map2tris = map;
     }
 
+    /** Return the memory in bytes that is occupied by the data outside the Tetgen buffers */
+    size_t memory_usage() const {
+        return TetgenCells<4>::memory_usage()
+                + (map2tris_offsets.capacity() + map2tris.capacity()) * sizeof(int);
+    }
+
     /** Struct holding statistics about tetrahedra */
     struct Stat {
         double edgemin;    //!< Minimum edge length
@@ -554,7 +597,8 @@ public:
     } stat;
 
 private:
-    vector<vector<int>> map2tris; ///< data for mapping tetrahedron to the triangles
+    vector<int> map2tris_offsets; ///< i-th tetrahedron is mapped to map2tris[offsets[i]] ... map2tris[offsets[i+1]-1]
+    vector<int> map2tris;         ///< data for mapping tetrahedron to the triangles
 
     /** Return the tetrahedron type in vtk format */
     int get_cell_type() const { return VtkType::tetrahedron; }
@@ -601,6 +645,12 @@ public:
         map2hexs = map;
     }
 
+    /** Return the memory in bytes that is occupied by the data outside the Tetgen buffers */
+    size_t memory_usage() const {
+        return TetgenCells<4>::memory_usage() + quads.capacity() * sizeof(SimpleQuad)
+                + map2hexs.capacity() * sizeof(array<int,2>);
+    }
+
 protected:
     vector<SimpleQuad> quads;
     vector<array<int,2>> map2hexs;
@@ -631,8 +681,8 @@ public:
 
     /** Return the indices of quadrangles connected to i-th hexahedron */
     vector<int> to_quads(const int i) const {
-        require(i >= 0 && i < (int)map2quads.size(), "Invalid index: " + d2s(i));
-        return map2quads[i];
+        require(i >= 0 && i < (int)map2quads_offsets.size() - 1, "Invalid index: " + d2s(i));
+        return vector<int>(map2quads.begin() + map2quads_offsets[i], map2quads.begin() + map2quads_offsets[i+1]);
     }
 
     /** Return the index of tetrahedron connected to i-th hexahedron */
@@ -647,14 +697,22 @@ public:
     /** Export bulk hexahedra in Deal.II format */
     vector<dealii::CellData<3>> export_bulk() const;
 
-    /** Store the data for mapping hexahedron to quadrangles */
-    void store_map(vector<vector<int>>& map) {
+    /** Store the data for mapping hexahedron to quadrangles in compressed sparse row format */
+    void store_map(const vector<int>& offsets, const vector<int>& map) {
+        map2quads_offsets = offsets;
         map2quads = map;
     }
 
+    /** Return the memory in bytes that is occupied by the data outside the Tetgen buffers */
+    size_t memory_usage() const {
+        return TetgenCells<8>::memory_usage() + hexs.capacity() * sizeof(SimpleHex)
+                + (map2quads_offsets.capacity() + map2quads.capacity()) * sizeof(int);
+    }
+
 protected:
     vector<SimpleHex> hexs;
-    vector<vector<int>> map2quads;
+    vector<int> map2quads_offsets; ///< i-th hexahedron is mapped to map2quads[offsets[i]] ... map2quads[offsets[i+1]-1]
+    vector<int> map2quads;         ///< data for mapping hexahedron to the quadrangles
 
     /** Return the hexahedron type in vtk format */
     int get_cell_type() const { return VtkType::hexahedron; }
@@ -48,6 +48,31 @@ public:
      * resemble Voronoi cells but are still something else, i.e pseudo Voronoi cells. */
     void calc_pseudo_3D_vorocells(vector<vector<unsigned>>& cells, const bool vacuum) const;
 
+    /** Append the bulk and vacuum nodes that are located outside the given box to the mesh generators.
+     * Reusable are the nodes added by Tetgen and the nodes that were already reused while making this mesh;
+     * the latter are in the end of bulk & vacuum generator ranges. Used to make the mesh incrementally.
+     * The nodes are appended in lexicographic order of their coordinates.
+     * @param n_bulk_own    number of bulk generators in this mesh that were not reused from earlier mesh
+     * @param n_vacuum_own  number of vacuum generators in this mesh that were not reused from earlier mesh
+     */
+    void get_tetgen_nodes(Medium& bulk, Medium& vacuum, const Point3& box_min, const Point3& box_max,
+            const int n_bulk_own, const int n_vacuum_own) const;
+
+    /** @brief Move the mesh nodes while keeping the mesh topology intact.
+     * Surface nodes are displaced by given amount, the displacements of other tetrahedral nodes
+     * are relaxed with Laplacian smoothing and the hexahedral nodes follow their tetrahedral ones.
+     * In case some of the hexahedra gets inverted, the initial node positions are restored.
+     * @param displacements  displacements of surface nodes
+     * @return  0 - morphing succeeded, 1 - some of the hexahedra got inverted */
+    int morph(const vector<Vec3>& displacements);
+
+    /** @brief Export the vertices and hexahedra of vacuum or bulk domain in the form of Deal.II triangulation.
+     * The vertices that are not used by the domain are removed with preserved order, like
+     * GridTools::delete_unused_vertices would do, and the cell vertices are given in Deal.II order.
+     * As hexahedra are generated with positive orientation, no further clean-up is needed.
+     * @param region  TYPES.VACUUM or TYPES.BULK */
+    void export_dealii(vector<dealii::Point<3>>& vertices, vector<dealii::CellData<3>>& cells, const int region) const;
+
     /** Map the triangle to the tetrahedron by specifying the region (vacuum or bulk)  */
     int tri2tet(const int tri, const int region) const;
 
@@ -57,6 +82,13 @@ public:
     /** Write bulk or vacuum mesh */
     void write_separate(const string& file_name, const int type);
 
+    /** Release the Tetgen write buffer and the parts of read buffer that are not used after the
+     * mesh generation; the mesh stays readable but can't be fed to Tetgen anymore */
+    void compact();
+
+    /** Return the memory in bytes that is occupied by the mesh */
+    size_t memory_usage() const;
+
     TetgenNodes nodes = TetgenNodes(&tetIOout, &tetIOin); ///< data & operations for mesh nodes
     TetgenEdges edges = TetgenEdges(&tetIOout);           ///< data & operations for mesh edges
     TetgenFaces tris = TetgenFaces(&tetIOout, &tetIOin); ///< data & operations for mesh triangles
@@ -79,17 +111,77 @@ public:
     string to_str() const { stringstream ss; ss << (*this); return ss.str(); }
 
 private:
+    typedef pair<array<int,3>, int> TetFace; ///< sorted nodes of tetrahedron face & its location in tetrahedron
+
     tetgenio tetIOin;   ///< Writable mesh data in Tetgen format
     tetgenio tetIOout;  ///< Readable mesh data in Tetgen format
 
+    static constexpr int fmesh_version = 2;          ///< version of native mesh file format
+    static constexpr int fmesh_alignment = 8;        ///< alignment of data arrays in native mesh file [bytes]
+    const string fmesh_label = "FemocsMesh";         ///< label of native mesh data
+
     void write_bin(ofstream &out) const;
 
+    /** Write mesh into restart file in native format */
+    void write_restart(ofstream &out) const;
+
+    /** Write nodes, cells, their markers and all the mappings between them in native binary format */
+    void write_fmesh(ofstream &out) const;
+
+    /** Read mesh in native binary format via memory mapping; no mesh conversion nor Tetgen calls are performed.
+     * @param file_name  path to the file with native mesh
+     * @param in         stream of the same file positioned to the beginning of native mesh header
+     * @return 0 on success, 1 if the file is invalid, truncated or written on incompatible machine
+     */
+    int read_fmesh(const string& file_name, ifstream &in);
+
     void write_msh(ofstream &out) const;
 
     void write_vtk(ofstream &out);
 
-    /** Function to generate mesh from surface, bulk and vacuum atoms */
-    int generate_union(const Medium& bulk, const Medium& surf, const Medium& vacuum, const string& cmd);
+    /** Function to generate mesh from surface, bulk and vacuum atoms;
+     * with n_slabs > 1 Delaunay triangulation is performed in parallel */
+    int generate_union(const Medium& bulk, const Medium& surf, const Medium& vacuum,
+            const string& cmd, const int n_slabs);
+
+    /** @brief Perform Delaunay triangulation of input buffer in overlapping slabs in parallel
+     * and refine the merged triangulation with given command into output buffer.
+     * If the slabs can't be merged, the triangulation is performed serially. */
+    int recalc_parallel(const string& cmd, const int n_slabs);
+
+    /** @brief Triangulate the overlapping slabs of input nodes and merge the tetrahedra
+     * that are owned by the slab and that are Delaunay also in the whole system.
+     * @param elems       nodes of merged tetrahedra
+     * @param open_faces  faces of merged tetrahedra that are not shared with other merged tetrahedra
+     * @return  true if triangulation failed */
+    bool triangulate_slabs(vector<int>& elems, vector<TetFace>& open_faces, const int n_slabs) const;
+
+    /** Fill the holes between merged slabs with Delaunay tetrahedra. The slab tetrahedra,
+     * whose open faces don't match the seam triangulation, are moved into the seams.
+     * @return true if the result doesn't cover the convex hull of input nodes */
+    bool fill_slab_seams(vector<int>& elems, vector<TetFace>& open_faces) const;
+
+    /** Check whether the merged slab tetrahedra have the same count and total volume
+     * as the serial Delaunay triangulation of input buffer */
+    bool matches_serial_delaunay(const vector<int>& elems) const;
+
+    /** Calculate the circumcentre and circumradius of tetrahedron in input buffer;
+     * return false for degenerate tetrahedron */
+    bool calc_circumsphere(const int* elem, Point3& centre, double& radius) const;
+
+    /** Return six times the signed volume of tetrahedron in input buffer formed by face and node */
+    double calc_orientation(const array<int,3>& face, const int node) const;
+
+    /** Calculate the total volume of tetrahedra in input buffer */
+    double calc_volume(const vector<int>& elems) const;
+
+    /** Find the faces of tetrahedra and sort them by their nodes */
+    void calc_faces(const vector<int>& elems, vector<TetFace>& faces) const;
+
+    /** Renumber the nodes added by Tetgen and the tetrahedra along Hilbert curve to improve
+     * the memory locality of all the data that is derived from them. The ranges of
+     * generator nodes are not modified, as the rest of the code relies on them. */
+    void sort_spatial();
 
     /** @brief Separate tetrahedra & triangles into hexahedra & quadrangles
      * Separation is done by adding node to the centroid of the tetrahedron edges,
@@ -99,13 +191,28 @@ private:
      */
     bool generate_hexahedra();
 
-    /** Using the separated tetrahedra generate the triangular surface on the vacuum-material boundary */
-    int generate_surface(const string& cmd1, const string& cmd2);
+    /** Split tetrahedra & triangles into hexahedra & quadrangles by operating on flat arrays.
+     * The edges and faces are numbered by sorting and removing duplicate node tuples,
+     * which gives the same node and cell layout as tethex but without its incidence maps. */
+    void split_into_hexahedra();
+
+    /** Using the separated tetrahedra generate the triangular surface on the vacuum-material boundary.
+     * The mapping between triangles and tetrahedra and the neighbour list of tetrahedra are
+     * obtained from the shared faces of tetrahedra, i.e without recalculating the mesh in Tetgen. */
+    int generate_surface();
 
     /** Generate surface faces from elements and known location of surface nodes.
      * Overlapping faces are not cleaned. */
     void generate_manual_surface();
 
+    /** Return the memory in bytes that is occupied by the Tetgen buffer */
+    size_t memory_usage(const tetgenio& io) const;
+
+    /** Invert the mapping from cells to at most two other cells;
+     * the result is in compressed sparse row format with n_cells rows */
+    void invert_map(const vector<array<int,2>>& map, const int n_cells,
+            vector<int>& offsets, vector<int>& inverse) const;
+
     /** Delete the data of previously stored mesh and initialise a new one */
     void clear();
 
@@ -121,11 +228,21 @@ private:
     /** Smoothen the triangles using different versions of Taubin smoothing algorithm */
     void smoothen(const int n_steps, const double lambda, const double mu, const string& algorithm);
 
-    /** Smoothen the surface mesh using Taubin lambda|mu algorithm with inverse neighbour count weighting */
-    void laplace_smooth(const double scale, const vector<vector<unsigned>>& nborlist);
+    /** Calculate the weights of surface edges for Taubin smoothing with inverse neighbour count weighting */
+    void calc_laplace_weights(vector<double>& weights, const vector<int>& surf_nodes,
+            const vector<int>& offsets) const;
+
+    /** Calculate the weights of surface edges for Taubin smoothing with Fujiwara weighting */
+    void calc_fujiwara_weights(vector<double>& weights, const vector<int>& surf_nodes,
+            const vector<int>& offsets, const vector<int>& nbors) const;
+
+    /** Perform one lambda or mu step of Taubin smoothing for the surface nodes.
+     * The neighbours of the nodes and the edge weights are given in compressed sparse row format. */
+    void smooth_step(const double scale, const vector<int>& surf_nodes, const vector<int>& offsets,
+            const vector<int>& nbors, const vector<double>& weights, vector<Point3>& displacements);
 
-    /** Smoothen the surface mesh using Taubin lambda|mu algorithm with Fujiwara weighting */
-    void fujiwara_smooth(const double scale, const vector<vector<unsigned>>& nborlist);
+    /** Calculate the orientations of hexahedra; 0 indicates degenerate or inverted hexahedron */
+    void calc_hex_orientations(vector<int>& orientations) const;
 
     /** Locate the tetrahedron by the location of its nodes */
     int locate_element(SimpleElement& elem);
@@ -146,7 +263,17 @@ private:
      * Nodes with small amount of neighbours are either on the boundary of simubox or on the edge
      * of a hole, while nodes with large amount of neighbours are inside the bulk or vacuum domain.
      */
-    bool calc_ranks(vector<int>& ranks, const vector<vector<unsigned>>& nborlist);
+    bool calc_ranks(vector<int>& ranks, const vector<int>& offsets, const vector<int>& nbors);
+
+    /** @brief Find the nodes that are accessible from the seed node via the edges of the mesh.
+     *
+     * Frontier-based breadth-first search over the node graph in compressed sparse row format.
+     * The nodes flagged in visited are not entered; the entered node is flagged and expanded
+     * further only if its rank is at least min_rank.
+     * @return  indices of the entered nodes
+     */
+    vector<int> flood_fill(const int seed, const vector<int>& offsets, const vector<int>& nbors,
+            vector<char>& visited, const vector<int>& ranks, const int min_rank) const;
 
     /** Calculate the mapping between quadrangle and hexahedron indices */
     void calc_quad2hex2quad_mapping();
@@ -186,7 +313,7 @@ private:
 
     /** Specify implemented output file formats */
     bool valid_extension(const string &ext) const {
-        return ext == "restart" || ext == "bin" || ext == "msh";
+        return ext == "restart" || ext == "bin" || ext == "msh" || ext == "fmesh";
     }
 };
 
@@ -216,7 +216,7 @@ public:
     void calc_centroids();
 
     /** Return the edge-neighbours of i-th Voronoi face */
-    vector<int> get_neighbours(const int i) const {
+    const vector<int>& get_neighbours(const int i) const {
         require(i >= 0 && i < static_cast<int>(neighbours.size()), "Invalid index: " + d2s(i));
         return neighbours[i];
     }
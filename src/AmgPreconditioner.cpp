@@ -0,0 +1,397 @@
+/*
+ * AmgPreconditioner.cpp
+ *
+ *  Created on: 18.10.2026
+ */
+
+#include "AmgPreconditioner.h"
+#include "Macros.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+namespace femocs {
+
+void AmgPreconditioner::Csr::vmult(vector<double>& dst, const vector<double>& src) const {
+    dst.resize(n_rows);
+
+    #pragma omp parallel for
+    for (int i = 0; i < n_rows; ++i) {
+        double sum = 0;
+        for (int k = offsets[i]; k < offsets[i+1]; ++k)
+            sum += vals[k] * src[cols[k]];
+        dst[i] = sum;
+    }
+}
+
+AmgPreconditioner::Csr AmgPreconditioner::Csr::transpose() const {
+    Csr t;
+    t.n_rows = n_cols;
+    t.n_cols = n_rows;
+    t.offsets = vector<int>(n_cols + 1, 0);
+    t.cols.resize(cols.size());
+    t.vals.resize(vals.size());
+
+    for (int col : cols)
+        t.offsets[col+1]++;
+    for (int i = 0; i < n_cols; ++i)
+        t.offsets[i+1] += t.offsets[i];
+
+    vector<int> location(t.offsets.begin(), t.offsets.end() - 1);
+    for (int i = 0; i < n_rows; ++i)
+        for (int k = offsets[i]; k < offsets[i+1]; ++k) {
+            const int loc = location[cols[k]]++;
+            t.cols[loc] = i;
+            t.vals[loc] = vals[k];
+        }
+
+    return t;
+}
+
+AmgPreconditioner::Csr AmgPreconditioner::Csr::multiply(const Csr& b) const {
+    require(n_cols == b.n_rows, "Incompatible matrix sizes: " + d2s(n_cols) + " vs " + d2s(b.n_rows));
+
+    Csr c;
+    c.n_rows = n_rows;
+    c.n_cols = b.n_cols;
+    c.offsets = vector<int>(n_rows + 1, 0);
+
+    // the location of entry in current row of product; -1 means there's no entry
+    vector<int> location(b.n_cols, -1);
+
+    for (int i = 0; i < n_rows; ++i) {
+        const int row_start = c.cols.size();
+        for (int k = offsets[i]; k < offsets[i+1]; ++k) {
+            const double a = vals[k];
+            const int j = cols[k];
+            for (int l = b.offsets[j]; l < b.offsets[j+1]; ++l) {
+                const int col = b.cols[l];
+                if (location[col] < 0) {
+                    location[col] = c.cols.size();
+                    c.cols.push_back(col);
+                    c.vals.push_back(a * b.vals[l]);
+                } else
+                    c.vals[location[col]] += a * b.vals[l];
+            }
+        }
+        for (int k = row_start; k < (int) c.cols.size(); ++k)
+            location[c.cols[k]] = -1;
+        c.offsets[i+1] = c.cols.size();
+    }
+
+    return c;
+}
+
+void AmgPreconditioner::initialize(const SparseMatrix<double>& matrix, const double threshold) {
+    levels.clear();
+    coarse_cholesky.clear();
+    levels.push_back(Level());
+
+    // copy the system matrix into the finest level
+    const int n_rows = matrix.m();
+    Csr& A = levels[0].A;
+    A.n_rows = A.n_cols = n_rows;
+    A.offsets = vector<int>(n_rows + 1, 0);
+    A.cols.reserve(matrix.n_nonzero_elements());
+    A.vals.reserve(matrix.n_nonzero_elements());
+
+    for (int i = 0; i < n_rows; ++i) {
+        for (auto entry = matrix.begin(i); entry != matrix.end(i); ++entry) {
+            if (entry->value() == 0 && (int) entry->column() != i) continue;
+            A.cols.push_back(entry->column());
+            A.vals.push_back(entry->value());
+        }
+        A.offsets[i+1] = A.cols.size();
+    }
+
+    double strength = threshold;
+    while (true) {
+        Level& level = levels.back();
+        const Csr& A = level.A;
+        const int n = A.n_rows;
+
+        level.inv_diag = vector<double>(n, 0);
+        vector<bool> strong(A.cols.size(), false);
+
+        for (int i = 0; i < n; ++i)
+            for (int k = A.offsets[i]; k < A.offsets[i+1]; ++k)
+                if (A.cols[k] == i && A.vals[k] != 0)
+                    level.inv_diag[i] = 1.0 / A.vals[k];
+
+        // mark the connections that are strong enough to be followed during aggregation
+        for (int i = 0; i < n; ++i)
+            for (int k = A.offsets[i]; k < A.offsets[i+1]; ++k) {
+                const int j = A.cols[k];
+                if (j == i || level.inv_diag[i] == 0 || level.inv_diag[j] == 0) continue;
+                strong[k] = A.vals[k] * A.vals[k] * fabs(level.inv_diag[i] * level.inv_diag[j])
+                        >= strength * strength;
+            }
+
+        level.x.resize(n);
+        level.b.resize(n);
+        level.r.resize(n);
+
+        if (n <= max_coarse_size || (int) levels.size() >= max_levels)
+            break;
+
+        vector<int> aggregates;
+        const int n_aggregates = aggregate(A, strong, aggregates);
+        if (n_aggregates == 0 || n_aggregates > 0.8 * n)
+            break;
+
+        level.P = smoothed_prolongator(A, strong, aggregates, n_aggregates);
+        level.R = level.P.transpose();
+
+        Csr coarse = level.R.multiply(A.multiply(level.P));
+        levels.push_back(Level());
+        levels.back().A = move(coarse);
+        strength *= 0.5;
+    }
+
+    if (levels.back().A.n_rows <= max_direct_size)
+        factorize_coarse();
+}
+
+int AmgPreconditioner::aggregate(const Csr& A, const vector<bool>& strong, vector<int>& aggregates) const {
+    const int n = A.n_rows;
+    aggregates = vector<int>(n, -1);
+    vector<bool> connected(n, false);
+    int n_aggregates = 0;
+
+    // Pass 1: make aggregates from the dofs whose all strong neighbours are still free
+    for (int i = 0; i < n; ++i) {
+        bool free = true;
+        for (int k = A.offsets[i]; k < A.offsets[i+1]; ++k)
+            if (strong[k]) {
+                connected[i] = true;
+                free &= aggregates[A.cols[k]] < 0;
+            }
+
+        if (!connected[i] || !free || aggregates[i] >= 0) continue;
+
+        aggregates[i] = n_aggregates;
+        for (int k = A.offsets[i]; k < A.offsets[i+1]; ++k)
+            if (strong[k])
+                aggregates[A.cols[k]] = n_aggregates;
+        n_aggregates++;
+    }
+
+    // Pass 2: attach the remaining dofs to the aggregates of their strong neighbours
+    vector<int> pass1_aggregates = aggregates;
+    for (int i = 0; i < n; ++i) {
+        if (aggregates[i] >= 0) continue;
+        for (int k = A.offsets[i]; k < A.offsets[i+1]; ++k)
+            if (strong[k] && pass1_aggregates[A.cols[k]] >= 0) {
+                aggregates[i] = pass1_aggregates[A.cols[k]];
+                break;
+            }
+    }
+
+    // Pass 3: make new aggregates from whatever is left
+    for (int i = 0; i < n; ++i) {
+        if (aggregates[i] >= 0 || !connected[i]) continue;
+        aggregates[i] = n_aggregates;
+        for (int k = A.offsets[i]; k < A.offsets[i+1]; ++k)
+            if (strong[k] && aggregates[A.cols[k]] < 0)
+                aggregates[A.cols[k]] = n_aggregates;
+        n_aggregates++;
+    }
+
+    return n_aggregates;
+}
+
+AmgPreconditioner::Csr AmgPreconditioner::smoothed_prolongator(const Csr& A, const vector<bool>& strong,
+        const vector<int>& aggregates, const int n_aggregates) const
+{
+    const int n = A.n_rows;
+
+    // Diagonal of the filtered matrix, where weak connections are lumped into diagonal
+    vector<double> diag(n, 0);
+    for (int i = 0; i < n; ++i) {
+        double weak_sum = 0;
+        for (int k = A.offsets[i]; k < A.offsets[i+1]; ++k) {
+            if (A.cols[k] == i) diag[i] += A.vals[k];
+            else if (!strong[k]) weak_sum += A.vals[k];
+        }
+        if (diag[i] + weak_sum > 0) diag[i] += weak_sum;
+    }
+
+    // Gershgorin estimate for the spectral radius of D^-1 * A_filtered
+    double rho = 1.0;
+    for (int i = 0; i < n; ++i) {
+        if (diag[i] <= 0) continue;
+        double row_sum = diag[i];
+        for (int k = A.offsets[i]; k < A.offsets[i+1]; ++k)
+            if (strong[k]) row_sum += fabs(A.vals[k]);
+        rho = max(rho, row_sum / diag[i]);
+    }
+    const double omega = 4.0 / 3.0 / rho;
+
+    // P = (I - omega * D^-1 * A_filtered) * P_tentative,
+    // where P_tentative is piecewise constant on the aggregates
+    Csr P;
+    P.n_rows = n;
+    P.n_cols = n_aggregates;
+    P.offsets = vector<int>(n + 1, 0);
+    vector<int> location(n_aggregates, -1);
+
+    auto add_entry = [&P, &location](const int col, const double value) {
+        if (location[col] < 0) {
+            location[col] = P.cols.size();
+            P.cols.push_back(col);
+            P.vals.push_back(value);
+        } else
+            P.vals[location[col]] += value;
+    };
+
+    for (int i = 0; i < n; ++i) {
+        const int row_start = P.cols.size();
+        if (diag[i] > 0) {
+            const double factor = omega / diag[i];
+            if (aggregates[i] >= 0)
+                add_entry(aggregates[i], 1.0 - factor * diag[i]);
+            for (int k = A.offsets[i]; k < A.offsets[i+1]; ++k)
+                if (strong[k] && aggregates[A.cols[k]] >= 0)
+                    add_entry(aggregates[A.cols[k]], -factor * A.vals[k]);
+        } else if (aggregates[i] >= 0)
+            add_entry(aggregates[i], 1.0);
+
+        for (int k = row_start; k < (int) P.cols.size(); ++k)
+            location[P.cols[k]] = -1;
+        P.offsets[i+1] = P.cols.size();
+    }
+
+    return P;
+}
+
+bool AmgPreconditioner::factorize_coarse() {
+    const Csr& A = levels.back().A;
+    const int n = A.n_rows;
+    coarse_cholesky = vector<double>(n * n, 0);
+    vector<double>& L = coarse_cholesky;
+
+    for (int i = 0; i < n; ++i)
+        for (int k = A.offsets[i]; k < A.offsets[i+1]; ++k)
+            if (A.cols[k] <= i)
+                L[i * n + A.cols[k]] = A.vals[k];
+
+    for (int j = 0; j < n; ++j) {
+        double d = L[j * n + j];
+        for (int k = 0; k < j; ++k)
+            d -= L[j * n + k] * L[j * n + k];
+        if (d <= 0) {
+            coarse_cholesky.clear();
+            return false;
+        }
+        d = sqrt(d);
+        L[j * n + j] = d;
+
+        #pragma omp parallel for if (n - j > 256)
+        for (int i = j + 1; i < n; ++i) {
+            double s = L[i * n + j];
+            for (int k = 0; k < j; ++k)
+                s -= L[i * n + k] * L[j * n + k];
+            L[i * n + j] = s / d;
+        }
+    }
+
+    return true;
+}
+
+void AmgPreconditioner::solve_coarse() const {
+    const Level& level = levels.back();
+    const int n = level.A.n_rows;
+
+    // without the factorization, approximate the solution with Gauss-Seidel sweeps
+    if (coarse_cholesky.empty()) {
+        fill(level.x.begin(), level.x.end(), 0.0);
+        for (int i = 0; i < 10; ++i) {
+            smooth(level, true);
+            smooth(level, false);
+        }
+        return;
+    }
+
+    const vector<double>& L = coarse_cholesky;
+    vector<double>& x = level.x;
+
+    // solve L * y = b and L^T * x = y
+    for (int i = 0; i < n; ++i) {
+        double s = level.b[i];
+        for (int k = 0; k < i; ++k)
+            s -= L[i * n + k] * x[k];
+        x[i] = s / L[i * n + i];
+    }
+    for (int i = n - 1; i >= 0; --i) {
+        double s = x[i];
+        for (int k = i + 1; k < n; ++k)
+            s -= L[k * n + i] * x[k];
+        x[i] = s / L[i * n + i];
+    }
+}
+
+void AmgPreconditioner::smooth(const Level& level, const bool forward) const {
+    const Csr& A = level.A;
+    const int n = A.n_rows;
+    const int first = forward ? 0 : n - 1;
+    const int step = forward ? 1 : -1;
+
+    for (int m = 0, i = first; m < n; ++m, i += step) {
+        double residual = level.b[i];
+        for (int k = A.offsets[i]; k < A.offsets[i+1]; ++k)
+            residual -= A.vals[k] * level.x[A.cols[k]];
+        level.x[i] += residual * level.inv_diag[i];
+    }
+}
+
+void AmgPreconditioner::vcycle(const int l) const {
+    if (l == n_levels() - 1) {
+        solve_coarse();
+        return;
+    }
+
+    const Level& level = levels[l];
+    const Level& coarse = levels[l+1];
+    const int n = level.A.n_rows;
+
+    fill(level.x.begin(), level.x.end(), 0.0);
+    smooth(level, true);
+
+    level.A.vmult(level.r, level.x);
+    #pragma omp parallel for
+    for (int i = 0; i < n; ++i)
+        level.r[i] = level.b[i] - level.r[i];
+
+    level.R.vmult(coarse.b, level.r);
+    vcycle(l + 1);
+
+    #pragma omp parallel for
+    for (int i = 0; i < n; ++i)
+        for (int k = level.P.offsets[i]; k < level.P.offsets[i+1]; ++k)
+            level.x[i] += level.P.vals[k] * coarse.x[level.P.cols[k]];
+
+    smooth(level, false);
+}
+
+void AmgPreconditioner::vmult(Vector<double>& dst, const Vector<double>& src) const {
+    require(n_levels() > 0, "Preconditioner is not initialized!");
+    const Level& level = levels[0];
+    const int n = level.A.n_rows;
+
+    for (int i = 0; i < n; ++i)
+        level.b[i] = src(i);
+    vcycle(0);
+    for (int i = 0; i < n; ++i)
+        dst(i) = level.x[i];
+}
+
+double AmgPreconditioner::operator_complexity() const {
+    if (levels.empty()) return 0;
+    size_t n_nonzeros = 0;
+    for (const Level& level : levels)
+        n_nonzeros += level.A.vals.size();
+    return n_nonzeros / (double) levels[0].A.vals.size();
+}
+
+} /* namespace femocs */
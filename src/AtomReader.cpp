@@ -86,6 +86,33 @@ bool AtomReader::calc_rms_distance() {
     return data.rms_distance >= conf->distance_tol;
 }
 
+bool AtomReader::get_moved_region(Point3& box_min, Point3& box_max, const double min_distance) const {
+    box_min = Point3(DBL_MAX);
+    box_max = Point3(-DBL_MAX);
+
+    const size_t n_atoms = size();
+    if (n_atoms != previous_points.size())
+        return false;
+
+    const double min_distance2 = min_distance * min_distance;
+    for (size_t i = 0; i < n_atoms; ++i) {
+        if (previous_types[i] == TYPES.CLUSTER || previous_types[i] == TYPES.EVAPORATED ||
+                previous_types[i] == TYPES.FIXED)
+            continue;
+
+        Point3 point = get_point(i);
+        if (point.distance2(previous_points[i]) <= min_distance2)
+            continue;
+
+        for (int j = 0; j < 3; ++j) {
+            box_min[j] = min(box_min[j], min(point[j], previous_points[i][j]));
+            box_max[j] = max(box_max[j], max(point[j], previous_points[i][j]));
+        }
+    }
+
+    return true;
+}
+
 void AtomReader::save_current_run_points() {
     const int n_atoms = size();
 
@@ -27,12 +27,21 @@ ConstCoarsener::ConstCoarsener() : Coarsener() {}
 
 ConstCoarsener::ConstCoarsener(const double r0_min) : Coarsener(Point3(), 0, 0, 0, r0_min) {}
 
-FlatlandCoarsener::FlatlandCoarsener() : Coarsener(), origin2d(0.0) {}
+FlatlandCoarsener::FlatlandCoarsener() : Coarsener() {}
 
 FlatlandCoarsener::FlatlandCoarsener(const Point3 &origin, const double exp, const double radius,
         const double A, const double r0_min, const double r0_max) :
-        Coarsener(origin, exp, radius, A, r0_min, r0_max),
-        origin2d(origin.x, origin.y) {}
+        FlatlandCoarsener(vector<Point3>{origin}, exp, radius, A, r0_min, r0_max) {}
+
+FlatlandCoarsener::FlatlandCoarsener(const vector<Point3> &origins, const double exp,
+        const double radius, const double A, const double r0_min, const double r0_max) :
+        Coarsener(origins.size() > 0 ? origins[0] : Point3(0), exp, radius, A, r0_min, r0_max),
+        origins3d(origins)
+{
+    origins2d.reserve(origins.size());
+    for (const Point3 &origin : origins)
+        origins2d.push_back(Point2(origin.x, origin.y));
+}
 
 CylinderCoarsener::CylinderCoarsener() : Coarsener(), origin2d(0.0) {}
 
@@ -175,29 +184,114 @@ vector<Point3> NanotipCoarsener::get_points(const double zmin) {
 }
 
 void Coarseners::generate(const Medium &medium, const double radius,
-    const Config::CoarseFactor &cf, const double latconst)
+    const Config::CoarseFactor &cf, const double latconst, const int n_roi)
 {
-    const int n_atoms = medium.size();
-    require(n_atoms > 0, "Not enough points to generate coarseners.");
-    require(cf.r0_cylinder >= 0 && cf.r0_sphere >= 0, "Coarsening factors must be non-negative!");
-    require(cf.r0_cylinder >= cf.r0_sphere, "Coarsening factor in cylinder wall must be >= coarsening factor in apex!");
-    require(cf.exponential > 0, "Coarsening rate must be positive!");
+    require(medium.size() > 0, "Not enough points to generate coarseners.");
 
+    this->radius = radius;                 // store the coarsener radius
     const double z_bot = get_z_mean(medium);
-    const double z_top = max(z_bot, medium.sizes.zmax - 0.5*radius);
-
     centre = Point3(medium.sizes.xmid, medium.sizes.ymid, z_bot);
-    Point3 apex(medium.sizes.xmid, medium.sizes.ymid, z_top);
 
-    this->radius = radius;                 // store the coarsener radius
+    get_apexes(apexes, medium, z_bot, n_roi);
+
+    centres.clear();
+    for (const Point3 &apex : apexes)
+        centres.push_back(Point3(apex.x, apex.y, z_bot));
+
+    set_factors(cf, latconst);
+
+    if (n_roi > 1)
+        write_verbose_msg("Detected " + d2s(apexes.size()) + " regions of interest");
+}
+
+void Coarseners::set_factors(const Config::CoarseFactor &cf, const double latconst) {
+    require(cf.r0_cylinder >= 0 && cf.r0_sphere >= 0, "Coarsening factors must be non-negative!");
+    require(cf.r0_cylinder >= cf.r0_sphere, "Coarsening factor in cylinder wall must be >= coarsening factor in apex!");
+    require(cf.exponential > 0, "Coarsening rate must be positive!");
+
     amplitude = cf.amplitude * latconst;
     r0_cylinder = cf.r0_cylinder * 0.25 * latconst;
     const double r0_sphere = cf.r0_sphere * 0.25 * latconst;
     const double r0_flat = min(amplitude*1e20, r0_cylinder);
 
     coarseners.clear();
-    attach_coarsener( make_shared<NanotipCoarsener>(apex, cf.exponential, radius, amplitude, r0_sphere, r0_cylinder) );
-    attach_coarsener( make_shared<FlatlandCoarsener>(centre, cf.exponential, radius, amplitude, r0_flat) );
+    for (const Point3 &apex : apexes)
+        attach_coarsener( make_shared<NanotipCoarsener>(apex, cf.exponential, radius, amplitude, r0_sphere, r0_cylinder) );
+    attach_coarsener( make_shared<FlatlandCoarsener>(centres, cf.exponential, radius, amplitude, r0_flat) );
+}
+
+void Coarseners::get_apexes(vector<Point3> &apexes, const Medium& medium,
+        const double z_bot, const int n_roi)
+{
+    apexes.clear();
+
+    // For single region, place its apex to the middle of the system
+    if (n_roi <= 1 || radius <= 0) {
+        const double z_top = max(z_bot, medium.sizes.zmax - 0.5*radius);
+        apexes.push_back(Point3(medium.sizes.xmid, medium.sizes.ymid, z_top));
+        return;
+    }
+
+    // make the height map with the bin width equal to the radius of coarsening cylinder
+    vector<int> highest;
+    int n_bins_x, n_bins_y;
+    get_histogram(highest, n_bins_x, n_bins_y, radius, medium);
+
+    // locate the bins that are higher than their neighbours and
+    // whose height above the substrate is enough to consider them as protrusions
+    vector<int> peaks;
+    for (int iy = 0; iy < n_bins_y; ++iy)
+        for (int ix = 0; ix < n_bins_x; ++ix) {
+            const int bin = iy * n_bins_x + ix;
+            const int i = highest[bin];
+            if (i < 0) continue;
+
+            const double z = medium.get_point(i).z;
+            if (z - z_bot < 0.5 * radius) continue;
+
+            bool is_peak = true;
+            for (int jy = max(0, iy-1); jy <= min(n_bins_y-1, iy+1) && is_peak; ++jy)
+                for (int jx = max(0, ix-1); jx <= min(n_bins_x-1, ix+1); ++jx) {
+                    const int nbor_bin = jy * n_bins_x + jx;
+                    const int j = highest[nbor_bin];
+                    if (j < 0 || nbor_bin == bin) continue;
+
+                    // in case of equal heights give priority to the bin with smaller index
+                    const double z_nbor = medium.get_point(j).z;
+                    if (z_nbor > z || (z_nbor == z && nbor_bin < bin)) {
+                        is_peak = false;
+                        break;
+                    }
+                }
+
+            if (is_peak) peaks.push_back(i);
+        }
+
+    // pick the highest peaks that are sufficiently far from each other
+    // so that the cylinders of the regions do not overlap
+    sort(peaks.begin(), peaks.end(), [&medium](const int i, const int j) {
+        return medium.get_point(i).z > medium.get_point(j).z;
+    });
+
+    const double min_distance2 = 4.0 * radius * radius;
+    for (int i : peaks) {
+        const Point3 peak = medium.get_point(i);
+        bool is_separate = true;
+        for (const Point3 &apex : apexes)
+            if (peak.distance2(Point2(apex.x, apex.y)) < min_distance2) {
+                is_separate = false;
+                break;
+            }
+
+        if (is_separate)
+            apexes.push_back(Point3(peak.x, peak.y, max(z_bot, peak.z - 0.5*radius)));
+        if ((int)apexes.size() >= n_roi)
+            break;
+    }
+
+    // if no protrusions were found, fall back to the single region in the middle of the system
+    if (apexes.size() == 0)
+        get_apexes(apexes, medium, z_bot, 1);
 }
 
 double Coarseners::get_z_mean(const Medium& medium) {
@@ -265,8 +359,37 @@ void Coarseners::get_histogram(vector<int> &bins, vector<double> &bounds, const
     }
 }
 
+void Coarseners::get_histogram(vector<int> &highest, int &n_bins_x, int &n_bins_y,
+        const double bin_width, const Medium& medium)
+{
+    require(bin_width > 0, "Invalid bin width: " + d2s(bin_width));
+    const int n_atoms = medium.size();
+    const double xmin = medium.sizes.xmin;
+    const double ymin = medium.sizes.ymin;
+
+    n_bins_x = max(1, (int) ceil(medium.sizes.xbox / bin_width));
+    n_bins_y = max(1, (int) ceil(medium.sizes.ybox / bin_width));
+    highest = vector<int>(n_bins_x * n_bins_y, -1);
+
+    // store the index of the highest atom in every bin
+    for (int i = 0; i < n_atoms; ++i) {
+        Point3 point = medium.get_point(i);
+        const int ix = min(n_bins_x - 1, max(0, (int) ((point.x - xmin) / bin_width)));
+        const int iy = min(n_bins_y - 1, max(0, (int) ((point.y - ymin) / bin_width)));
+        int &j = highest[iy * n_bins_x + ix];
+        if (j < 0 || point.z > medium.get_point(j).z)
+            j = i;
+    }
+}
+
 double Coarseners::get_r0_inf(const Medium::Sizes &s) {
-    const double max_distance = centre.distance(Point3(s.xmin, s.ymin, s.zmin));
+    // measure the distance from the closest region of interest
+    const Point3 corner(s.xmin, s.ymin, s.zmin);
+    double max_distance = DBL_MAX;
+    for (const Point3 &c : centres)
+        max_distance = min(max_distance, c.distance(corner));
+    if (centres.size() == 0)
+        max_distance = centre.distance(corner);
     if ((max_distance - radius) > 0)
         return 1.1 * amplitude * sqrt(max_distance - radius) + r0_cylinder;
     else
@@ -275,10 +398,13 @@ double Coarseners::get_r0_inf(const Medium::Sizes &s) {
 
 bool Coarseners::inside_interesting_region(const Point3& p) const {
     const double min_angle = M_PI / 6.0;
-    Vec3 diff(p - centre);
-    bool inside_tip = diff.x * diff.x + diff.y * diff.y <= radius * radius;
-    bool inside_cone = asin(diff.z / diff.norm()) >= min_angle;
-    return inside_tip && inside_cone;
+    for (const Point3 &c : centres) {
+        Vec3 diff(p - c);
+        bool inside_tip = diff.x * diff.x + diff.y * diff.y <= radius * radius;
+        bool inside_cone = asin(diff.z / diff.norm()) >= min_angle;
+        if (inside_tip && inside_cone) return true;
+    }
+    return false;
 }
 
 void Coarseners::write_vtk(ofstream &out) const {
@@ -19,6 +19,7 @@ Config::Config() {
     path.infile = "";
     path.mesh_file = "";
     path.restart_file = "";
+    path.mesh_cache = "";
 
     behaviour.verbosity = "verbose";
     behaviour.project = "runaway";
@@ -42,6 +43,7 @@ Config::Config() {
 
     geometry.mesh_quality = "2.0";
     geometry.element_volume = "";
+    geometry.n_mesh_slabs = 1;
     geometry.nnn = 12;
     geometry.latconst = 3.61;
     geometry.coordination_cutoff = 3.1;
@@ -53,6 +55,9 @@ Config::Config() {
     geometry.bulk_height = 20;
     geometry.radius = 0.0;
     geometry.height = 0.0;
+    geometry.n_roi = 1;
+    geometry.remesh_buffer = 0;
+    geometry.morph_tol = 0;
     geometry.distance_tol = 0.0;
 
     tolerance.charge_min = 0.8;
@@ -62,6 +67,8 @@ Config::Config() {
 
     field.E0 = 0.0;
     field.ssor_param = 1.2;
+    field.precond = "ssor";
+    field.matrix_free = false;
     field.cg_tolerance = 1e-9;
     field.n_cg = 10000;
     field.V0 = 0.0;
@@ -75,8 +82,14 @@ Config::Config() {
     heating.n_cg = 2000;
     heating.cg_tolerance = 1e-9;
     heating.ssor_param = 1.2;         // 1.2 is known to work well with Laplace
+    heating.precond = "ssor";
+    heating.assemble_tol = 1.0;
+    heating.direct_solver = false;
     heating.delta_time = 10.0;
     heating.dt_max = 1.0e5;
+    heating.dt_tolerance = 0.0;
+    heating.n_newton = 20;
+    heating.t_error = 0.1;
     heating.tau = 100.0;
 
     emission.work_function = 4.5;
@@ -97,6 +110,10 @@ Config::Config() {
     cfactor.r0_cylinder = 0;
     cfactor.r0_sphere = 0;
     cfactor.exponential = 0.5;
+    cfactor.node_budget = 0;
+    cfactor.elem_budget = 0;
+    cfactor.time_budget = 0;
+    cfactor.budget_tol = 0.1;
 }
 
 void Config::trim(string& str) {
@@ -155,12 +172,24 @@ void Config::read_all(const string& fname, bool full_run) {
     read_command("heat_ncg", heating.n_cg);
     read_command("heat_cgtol", heating.cg_tolerance);
     read_command("heat_ssor", heating.ssor_param);
+    read_command("heat_precond", heating.precond);
+    require(heating.precond == "ssor" || heating.precond == "amg",
+            "Unimplemented heat preconditioner: " + heating.precond);
+    read_command("heat_assemble_tol", heating.assemble_tol);
+    read_command("heat_direct", heating.direct_solver);
     read_command("heat_dt", heating.delta_time);
     read_command("heat_dtmax", heating.dt_max);
+    read_command("heat_dttol", heating.dt_tolerance);
+    read_command("n_newton", heating.n_newton);
+    read_command("t_error", heating.t_error);
     read_command("vscale_tau", heating.tau);
 
     read_command("field_mode", field.mode);
     read_command("field_ssor", field.ssor_param);
+    read_command("field_precond", field.precond);
+    require(field.precond == "ssor" || field.precond == "amg",
+            "Unimplemented field preconditioner: " + field.precond);
+    read_command("field_matrix_free", field.matrix_free);
     read_command("field_cgtol", field.cg_tolerance);
     read_command("field_ncg", field.n_cg);
     read_command("elfield", field.E0);
@@ -187,8 +216,12 @@ void Config::read_all(const string& fname, bool full_run) {
     read_command("nnn", geometry.nnn);
     read_command("mesh_quality", geometry.mesh_quality);
     read_command("element_volume", geometry.element_volume);
+    read_command("n_mesh_slabs", geometry.n_mesh_slabs);
     read_command("radius", geometry.radius);
     read_command("tip_height", geometry.height);
+    read_command("n_roi", geometry.n_roi);
+    read_command("remesh_buffer", geometry.remesh_buffer);
+    read_command("morph_tol", geometry.morph_tol);
     read_command("box_width", geometry.box_width);
     read_command("box_height", geometry.box_height);
     read_command("bulk_height", geometry.bulk_height);
@@ -197,6 +230,7 @@ void Config::read_all(const string& fname, bool full_run) {
     read_command("infile", path.infile);
     read_command("mesh_file", path.mesh_file);
     read_command("restart_file", path.restart_file);
+    read_command("mesh_cache", path.mesh_cache);
 
     read_command("cluster_anal", run.cluster_anal);
     read_command("refine_apex", run.apex_refiner);
@@ -246,6 +280,10 @@ void Config::read_all(const string& fname, bool full_run) {
 
     // ...coarsening factors
     read_command("coarse_rate", cfactor.exponential);
+    read_command("node_budget", cfactor.node_budget);
+    read_command("elem_budget", cfactor.elem_budget);
+    read_command("time_budget", cfactor.time_budget);
+    read_command("budget_tol", cfactor.budget_tol);
     args = {cfactor.amplitude, (double)cfactor.r0_cylinder, (double)cfactor.r0_sphere};
     n_read_args = read_command("coarse_factor", args);
     cfactor.amplitude = args[0];
@@ -7,6 +7,7 @@
 
 #include <deal.II/numerics/data_out.h>
 #include <deal.II/base/work_stream.h>
+#include <deal.II/numerics/matrix_tools.h>
 
 #include "CurrentHeatSolver.h"
 #include "EmissionReader.h"
@@ -83,11 +84,11 @@ EmissionSolver<dim>::EmissionSolver(Triangulation<dim> *tria, vector<double>* bc
 
 template<int dim>
 HeatSolver<dim>::HeatSolver() :
-        EmissionSolver<dim>(), current_solver(NULL), one_over_delta_time(0) {}
+        EmissionSolver<dim>(), current_solver(NULL), one_over_delta_time(0), matrices_assembled(false) {}
 
 template<int dim>
 HeatSolver<dim>::HeatSolver(Triangulation<dim> *tria, const CurrentSolver<dim> *cs, vector<double>* bcs) :
-        EmissionSolver<dim>(tria, bcs), current_solver(cs), one_over_delta_time(0) {}
+        EmissionSolver<dim>(tria, bcs), current_solver(cs), one_over_delta_time(0), matrices_assembled(false) {}
 
 template<int dim>
 void HeatSolver<dim>::write_vtk(ofstream& out) const {
@@ -110,40 +111,54 @@ void HeatSolver<dim>::setup_system() {
     joule_heat.reinit(n_dofs);
     total_heat.reinit(n_dofs);
     this->dof_volume.resize(n_dofs);
+
+    mass_matrix.reinit(this->sparsity_pattern);
+    stiffness_matrix.reinit(this->sparsity_pattern);
+    matrices_assembled = false;
 }
 
 template<int dim>
-void HeatSolver<dim>::assemble(const double delta_time) {
+void HeatSolver<dim>::assemble_time_step(const double delta_time, const double theta) {
     require(current_solver, "NULL current solver can't be used!");
     require(delta_time > 0, "Invalid delta time: " + d2s(delta_time));
+    require(theta >= 0.5 && theta <= 1.0, "Unstable or invalid theta: " + d2s(theta));
 
     this->one_over_delta_time = 1.0 / delta_time;
-    this->system_matrix = 0;
-    this->system_rhs = 0;
 
-    LinearSystem system(&this->system_rhs, &this->system_matrix);
-    QGauss<dim> quadrature_formula(this->quadrature_degree);
-
-    const unsigned int n_dofs = this->fe.dofs_per_cell;
-    const unsigned int n_q_points = quadrature_formula.size();
+    // mass matrix depends only on the mesh
+    if (!matrices_assembled) {
+        mass_matrix = 0;
+        MatrixCreator::create_mass_matrix(this->dof_handler, QGauss<dim>(this->quadrature_degree), mass_matrix);
+        mass_matrix *= cu_rho_cp;
+    }
 
-    WorkStream::run(this->dof_handler.begin_active(),this->dof_handler.end(),
-            std::bind(&HeatSolver<dim>::assemble_local_cell,
-                    this,
-                    std::placeholders::_1,
-                    std::placeholders::_2,
-                    std::placeholders::_3),
-            std::bind(&HeatSolver<dim>::copy_global_cell,
-                    this,
-                    std::placeholders::_1,
-                    std::ref(system)),
-            ScratchData(this->fe, quadrature_formula, update_values | update_gradients | update_quadrature_points | update_JxW_values),
-            CopyData(n_dofs, n_q_points)
-    );
+    // thermal conductivity is lagged until temperatures have changed enough since last assembly
+    bool assemble_stiffness_matrix = !matrices_assembled;
+    if (!assemble_stiffness_matrix) {
+        Vector<double> temperature_change(this->solution);
+        temperature_change -= stiffness_temperature;
+        assemble_stiffness_matrix = temperature_change.linfty_norm() > this->conf->assemble_tol;
+    }
+    if (assemble_stiffness_matrix)
+        assemble_stiffness();
+
+    this->system_matrix.copy_from(stiffness_matrix);
+    this->system_matrix *= theta;
+    this->system_matrix.add(this->one_over_delta_time, mass_matrix);
+
+    // dof volumes are needed only for writing
+    const bool write_time = this->write_time();
+    this->calc_joule_heat(write_time);
+    mass_matrix.vmult(this->system_rhs, this->solution);
+    this->system_rhs *= this->one_over_delta_time;
+    if (theta < 1.0) {
+        Vector<double> conducted_heat(this->size());
+        stiffness_matrix.vmult(conducted_heat, this->solution);
+        this->system_rhs.add(theta - 1.0, conducted_heat);
+    }
+    this->system_rhs += this->joule_heat;
 
-    if (this->write_time()) {
-        this->calc_joule_heat();
-        this->calc_dof_volumes();
+    if (write_time) {
         //temporarily total_heat keeps the previous T component of the rhs
         for (int i = 0; i < this->total_heat.size(); ++i)
             this->total_heat[i] = this->system_rhs[i] - this->joule_heat[i];
@@ -151,7 +166,7 @@ void HeatSolver<dim>::assemble(const double delta_time) {
 
     this->assemble_rhs(BoundaryID::copper_surface);
 
-    if (this->write_time()){ // save total heat also
+    if (write_time) { // save total heat also
         for (int i = 0; i < this->total_heat.size(); ++i)
             this->total_heat[i] = this->system_rhs[i] - this->total_heat[i]; //subtract the previous T component
     }
@@ -160,166 +175,237 @@ void HeatSolver<dim>::assemble(const double delta_time) {
 }
 
 template<int dim>
-void HeatSolver<dim>::assemble_crank_nicolson(const double delta_time) {
-    require(false, "Implementation of Crank-Nicolson assembly not verified!");
-
-    /* TODO:
-     * change temperature_grad to temperature
-     * add prev_nottingham values
-     * interpolate prev_potential and prev_nottingham for current mesh
-     *   prev_potential could be read from heat_transfer
-     *   for nottingham something else should be done...
-     */
-
-    /*
-    require(current_solver, "NULL current solver can't be used!");
-
-    const double gamma = cu_rho_cp / delta_time;
-    this->system_matrix = 0;
-    this->system_rhs = 0;
+int HeatSolver<dim>::solve_adaptive(const double delta_time, const double dt_max, double& dt) {
+    require(delta_time > 0 && dt_max > 0, "Invalid delta time: " + d2s(delta_time) + ", " + d2s(dt_max));
+
+    const double tolerance = this->conf->dt_tolerance;
+    // step that is accepted regardless of its error to guarantee progress
+    const double dt_min = 1e-3 * min(delta_time, dt_max);
+    // limits to the change of time step between consecutive steps
+    const double min_factor = 0.2, max_factor = 5.0;
+
+    Vector<double> prev_temperature, euler_temperature;
+    double time_left = delta_time;
+    int n_cg = 0;
+
+    dt = max(dt_min, min(dt, dt_max));
+    while (time_left > 0) {
+        // instead of leaving a tiny remainder, finish the interval
+        const bool last_step = 1.1 * dt >= time_left;
+        const double step = last_step ? time_left : dt;
+        prev_temperature = this->solution;
+
+        assemble_time_step(step, 1.0);
+        int ncg = this->solve();
+        if (ncg < 0) return ncg - n_cg;
+        n_cg += ncg;
+        euler_temperature = this->solution;
+
+        // second order solution starts from the same temperatures, but from better initial guess;
+        // both solutions satisfy the same Dirichlet BCs
+        this->solution = prev_temperature;
+        assemble_crank_nicolson(step);
+        this->solution = euler_temperature;
+        ncg = this->solve();
+        if (ncg < 0) return ncg - n_cg;
+        n_cg += ncg;
+
+        // difference of the solutions estimates the local error of Euler step that scales as dt^2
+        euler_temperature -= this->solution;
+        const double error = euler_temperature.linfty_norm();
+        double factor = max_factor;
+        if (error > 0)
+            factor = max(min_factor, min(max_factor, 0.9 * sqrt(tolerance / error)));
+
+        if (error <= tolerance || step <= dt_min) {
+            // accept second order solution
+            time_left = last_step ? 0 : time_left - step;
+            // shortened last step should not reduce the suggested step
+            dt = last_step ? max(dt, step * factor) : step * factor;
+        } else {
+            this->solution = prev_temperature;
+            dt = step * factor;
+        }
+        dt = max(dt_min, min(dt, dt_max));
+    }
 
-    QGauss<dim> quadrature_formula(this->quadrature_degree);
-    QGauss<dim-1> face_quadrature_formula(this->quadrature_degree);
+    return n_cg;
+}
 
-    // Heating finite element values
-    FEValues<dim> fe_values(this->fe, quadrature_formula,
-            update_values | update_gradients | update_quadrature_points | update_JxW_values);
-    FEFaceValues<dim> fe_face_values(this->fe, face_quadrature_formula,
-            update_values | update_quadrature_points | update_JxW_values);
+template<int dim>
+int HeatSolver<dim>::solve_newton(double& t_change) {
+    require(current_solver, "NULL current solver can't be used!");
 
-    // Finite element values for accessing current calculation
-    FEValues<dim> fe_values_current(current_solver->fe, quadrature_formula, update_gradients);
+    LinearSystem system(&this->system_rhs, &this->system_matrix);
+    QGauss<dim> quadrature_formula(this->quadrature_degree);
 
-    const unsigned int dofs_per_cell = this->fe.dofs_per_cell;
+    const unsigned int n_dofs = this->fe.dofs_per_cell;
     const unsigned int n_q_points = quadrature_formula.size();
-    const unsigned int n_face_q_points = face_quadrature_formula.size();
 
-    FullMatrix<double> cell_matrix(dofs_per_cell, dofs_per_cell);
-    Vector<double> cell_rhs(dofs_per_cell);
+    this->system_matrix = 0;
+    this->system_rhs = 0;
 
-    vector<types::global_dof_index> local_dof_indices(dofs_per_cell);
+    // cells provide Jacobian J and minus residual -F
+    WorkStream::run(this->dof_handler.begin_active(),this->dof_handler.end(),
+            std::bind(&HeatSolver<dim>::assemble_newton_local_cell,
+                    this,
+                    std::placeholders::_1,
+                    std::placeholders::_2,
+                    std::placeholders::_3),
+            std::bind(&HeatSolver<dim>::copy_global_cell,
+                    this,
+                    std::placeholders::_1,
+                    std::ref(system)),
+            ScratchData(this->get_cell_geometry()),
+            CopyData(n_dofs, n_q_points)
+    );
 
-    // ---------------------------------------------------------------------------------------------
-    // The other solution values in the cell quadrature points
-    vector<Tensor<1, dim>> potential_grads(n_q_points);
-    vector<Tensor<1, dim>> prev_potential_grads(n_q_points);
-    vector<double> prev_temperatures(n_q_points);
-    vector<Tensor<1, dim>> prev_temperature_grads(n_q_points);
-    // ---------------------------------------------------------------------------------------------
+    // solve J * T_new = J * T - F instead of the update to apply the Dirichlet BC directly to the temperatures
+    this->system_matrix.vmult_add(this->system_rhs, this->solution);
+    this->assemble_rhs(BoundaryID::copper_surface);
+    this->append_dirichlet(BoundaryID::copper_bottom, this->dirichlet_bc_value);
+    this->apply_dirichlet();
 
-    typename DoFHandler<dim>::active_cell_iterator cell = this->dof_handler.begin_active();
-    typename DoFHandler<dim>::active_cell_iterator current_cell = current_solver->dof_handler.begin_active();
+    Vector<double> temperature_change(this->solution);
+    // Jacobian is not symmetric, therefore CG is not applicable
+    const int n_gmres = this->solve_gmres(this->conf->n_cg, this->conf->cg_tolerance,
+            this->conf->ssor_param, this->conf->precond == "amg");
+    temperature_change -= this->solution;
+    t_change = temperature_change.linfty_norm();
 
-    int face_index = 0;
-    for (; cell != this->dof_handler.end(); ++cell, ++current_cell) {
-        fe_values.reinit(cell);
-        cell_matrix = 0;
-        cell_rhs = 0;
+    if (this->write_time()) {
+        // store the heat sources for writing
+        this->calc_joule_heat(true);
+        this->system_rhs = 0;
+        this->assemble_rhs(BoundaryID::copper_surface);
+        this->total_heat = this->joule_heat;
+        this->total_heat += this->system_rhs;
+    }
 
-        fe_values.get_function_values(this->solution_save, prev_temperatures);
-        fe_values.get_function_gradients(this->solution_save, prev_temperature_grads);
+    return n_gmres;
+}
 
-        fe_values_current.reinit(current_cell);
-        fe_values_current.get_function_gradients(current_solver->solution, potential_grads);
-        fe_values_current.get_function_gradients(current_solver->solution_save, prev_potential_grads);
+template<int dim>
+void HeatSolver<dim>::assemble_newton_local_cell(const typename DoFHandler<dim>::active_cell_iterator &cell,
+        ScratchData &scratch_data, CopyData &copy_data) const
+{
+    const unsigned int n_dofs = copy_data.n_dofs;
+    const unsigned int n_q_points = copy_data.n_q_points;
 
-        // ----------------------------------------------------------------------------------------
-        // Local matrix assembly
-        // ----------------------------------------------------------------------------------------
-        for (unsigned int q = 0; q < n_q_points; ++q) {
+    // The temperature and current potential values in the cell quadrature points
+    vector<double> temperatures(n_q_points);
+    vector<Tensor<1, dim>> temperature_gradients(n_q_points);
+    vector<Tensor<1, dim>> potential_gradients(n_q_points);
 
-            double temperature = prev_temperatures[q];
-            double kappa = this->pq->kappa(temperature);
-            double sigma = this->pq->sigma(temperature);
+    typename CellGeometry<dim>::Values& cell_values = scratch_data.cell_values;
+    cell_values.reinit(cell->active_cell_index());
+    cell_values.get_function_values(this->solution, temperatures);
+    cell_values.get_function_gradients(this->solution, temperature_gradients);
+    cell_values.get_function_gradients(current_solver->solution, potential_gradients);
 
-            Tensor<1, dim> temperature_grad = prev_temperature_grads[q];
+    copy_data.cell_matrix = 0;
+    copy_data.cell_rhs = 0;
+    for (unsigned int q = 0; q < n_q_points; ++q) {
+        const double temperature = temperatures[q];
+        const double kappa = this->pq->kappa(temperature);
+        const double dkappa = this->pq->dkappa(temperature);
 
-            double pot_grad_squared = potential_grads[q].norm_square();
-            double prev_pot_grad_squared = prev_potential_grads[q].norm_square();
+        // Joule heat rho * |grad v|^2 and its derivative with respect to temperature; rho = 1 / sigma
+        const double sigma = this->pq->sigma(temperature);
+        const double pot_grad_squared = potential_gradients[q].norm_square();
+        const double joule_heat = pot_grad_squared / sigma;
+        const double djoule_heat = -pot_grad_squared * this->pq->dsigma(temperature) / (sigma * sigma);
 
-            for (unsigned int i = 0; i < dofs_per_cell; ++i) {
-                for (unsigned int j = 0; j < dofs_per_cell; ++j) {
-                    cell_matrix(i, j) += fe_values.JxW(q) * (
-                            gamma*fe_values.shape_value(i, q) * fe_values.shape_value(j, q) // Mass matrix
-                            + 0.5*kappa*fe_values.shape_grad(i, q) * fe_values.shape_grad(j, q) );
-                }
-                cell_rhs(i) += fe_values.JxW(q) * (
-                        gamma*fe_values.shape_value(i, q)*temperature
-                        - 0.5*kappa*fe_values.shape_grad(i, q)*temperature_grad  // TODO check this
-                        + 0.5*sigma*fe_values.shape_value(i, q)*(pot_grad_squared+prev_pot_grad_squared) );
-            }
-        }
+        for (unsigned int i = 0; i < n_dofs; ++i) {
+            const double conduction = temperature_gradients[q] * cell_values.shape_grad(i, q);
+            copy_data.cell_rhs(i) += cell_values.JxW(q) *
+                    (joule_heat * cell_values.shape_value(i, q) - kappa * conduction);
 
-        // ----------------------------------------------------------------------------------------
-        // Local right-hand side assembly
-        // ----------------------------------------------------------------------------------------
-        // Nottingham BC at the copper surface
-        for (unsigned int f = 0; f < GeometryInfo<dim>::faces_per_cell; ++f) {
-            if (cell->face(f)->boundary_id() == BoundaryID::copper_surface) {
-                fe_face_values.reinit(cell, f);
-                double nottingham_heat = this->get_face_bc(face_index++);
-
-                for (unsigned int q = 0; q < n_face_q_points; ++q) {
-                    for (unsigned int i = 0; i < dofs_per_cell; ++i) {
-                        cell_rhs(i) += fe_face_values.shape_value(i, q)
-                                * nottingham_heat * fe_face_values.JxW(q);
-                    }
-                }
+            for (unsigned int j = 0; j < n_dofs; ++j) {
+                copy_data.cell_matrix(i, j) += cell_values.JxW(q) * (
+                        kappa * cell_values.shape_grad(i, q) * cell_values.shape_grad(j, q)
+                        + dkappa * cell_values.shape_value(j, q) * conduction
+                        - djoule_heat * cell_values.shape_value(j, q) * cell_values.shape_value(i, q) );
             }
         }
-
-        cell->get_dof_indices(local_dof_indices);
-        for (unsigned int i = 0; i < dofs_per_cell; ++i) {
-            for (unsigned int j = 0; j < dofs_per_cell; ++j)
-                this->system_matrix.add(local_dof_indices[i], local_dof_indices[j], cell_matrix(i, j));
-
-            this->system_rhs(local_dof_indices[i]) += cell_rhs(i);
-        }
     }
-    //*/
+
+    cell->get_dof_indices(copy_data.dof_indices);
 }
 
 template<int dim>
-void HeatSolver<dim>::calc_joule_heat() {
+HeatSolver<dim>::JouleCopyData::JouleCopyData(const unsigned dofs_per_cell) :
+    joule_heat(dofs_per_cell), volume(dofs_per_cell), dof_indices(dofs_per_cell)
+{}
+
+template<int dim>
+void HeatSolver<dim>::calc_joule_heat(const bool calc_volumes) {
     require(current_solver, "NULL current solver can't be used!");
 
     this->joule_heat = 0;
+    if (calc_volumes) {
+        this->dof_volume.resize(this->size());
+        std::fill(this->dof_volume.begin(), this->dof_volume.end(), 0);
+    }
 
     QGauss<dim> quadrature_formula(this->quadrature_degree);
 
-    // Heating finite element values
-    FEValues<dim> fe_values(this->fe, quadrature_formula,
-            update_values | update_gradients | update_quadrature_points | update_JxW_values);
-
-    const unsigned int dofs_per_cell = this->fe.dofs_per_cell;
-    const unsigned int n_q_points = quadrature_formula.size();
+    WorkStream::run(this->dof_handler.begin_active(),this->dof_handler.end(),
+            std::bind(&HeatSolver<dim>::calc_joule_heat_local_cell,
+                    this,
+                    std::placeholders::_1,
+                    std::placeholders::_2,
+                    std::placeholders::_3,
+                    calc_volumes),
+            std::bind(&HeatSolver<dim>::copy_joule_heat,
+                    this,
+                    std::placeholders::_1,
+                    calc_volumes),
+            ScratchData(this->get_cell_geometry()),
+            JouleCopyData(this->fe.dofs_per_cell)
+    );
+}
 
-    vector<types::global_dof_index> local_dof_indices(dofs_per_cell);
+template<int dim>
+void HeatSolver<dim>::calc_joule_heat_local_cell(const typename DoFHandler<dim>::active_cell_iterator &cell,
+        ScratchData &scratch_data, JouleCopyData &copy_data, const bool calc_volumes) const
+{
+    typename CellGeometry<dim>::Values& cell_values = scratch_data.cell_values;
+    const unsigned int dofs_per_cell = copy_data.dof_indices.size();
+    const unsigned int n_q_points = this->cell_geometry.n_quadrature_points();
 
     // The other solution values in the cell quadrature points
     vector<Tensor<1, dim>> potential_gradients(n_q_points);
     vector<double> prev_temperatures(n_q_points);
 
-    typename DoFHandler<dim>::active_cell_iterator cell = this->dof_handler.begin_active();
+    cell_values.reinit(cell->active_cell_index());
+    cell_values.get_function_values(this->solution, prev_temperatures);
+    cell_values.get_function_gradients(current_solver->solution, potential_gradients);
 
-    for (; cell != this->dof_handler.end(); ++cell) {
-        fe_values.reinit(cell);
-        fe_values.get_function_values(this->solution, prev_temperatures);
-        fe_values.get_function_gradients(current_solver->solution, potential_gradients);
-
-        cell->get_dof_indices(local_dof_indices);
-        // Local joule heat vector assembly
-        for (unsigned int q = 0; q < n_q_points; ++q) {
-            double pot_grad_squared = potential_gradients[q].norm_square();
-            double temperature = prev_temperatures[q];
-            double rho = this->pq->evaluate_resistivity(temperature);
+    // Local joule heat vector assembly
+    copy_data.joule_heat = 0;
+    copy_data.volume = 0;
+    for (unsigned int q = 0; q < n_q_points; ++q) {
+        double pot_grad_squared = potential_gradients[q].norm_square();
+        double temperature = prev_temperatures[q];
+        double rho = this->pq->evaluate_resistivity(temperature);
 
-            for (unsigned int i = 0; i < dofs_per_cell; ++i) {
-                this->joule_heat(local_dof_indices[i]) += fe_values.JxW(q) *
-                        fe_values.shape_value(i, q) * rho * pot_grad_squared;
-            }
+        for (unsigned int i = 0; i < dofs_per_cell; ++i) {
+            copy_data.joule_heat(i) += cell_values.JxW(q) * cell_values.shape_value(i, q) * rho * pot_grad_squared;
+            if (calc_volumes)
+                copy_data.volume(i) += cell_values.JxW(q) * cell_values.shape_value(i, q);
         }
     }
+
+    cell->get_dof_indices(copy_data.dof_indices);
+}
+
+template<int dim>
+void HeatSolver<dim>::copy_joule_heat(const JouleCopyData &copy_data, const bool calc_volumes) {
+    this->joule_heat.add(copy_data.dof_indices, copy_data.joule_heat);
+    if (calc_volumes)
+        for (unsigned int i = 0; i < copy_data.dof_indices.size(); ++i)
+            this->dof_volume[copy_data.dof_indices[i]] += copy_data.volume(i);
 }
 
 template<int dim>
@@ -394,6 +480,35 @@ void HeatSolver<dim>::assemble_euler_implicit(const double delta_time) {
     }
 }
 
+template<int dim>
+void HeatSolver<dim>::assemble_stiffness() {
+    stiffness_matrix = 0;
+
+    // cells contribute nothing to rhs, therefore it is safe to pass system_rhs here
+    LinearSystem system(&this->system_rhs, &stiffness_matrix);
+    QGauss<dim> quadrature_formula(this->quadrature_degree);
+
+    const unsigned int n_dofs = this->fe.dofs_per_cell;
+    const unsigned int n_q_points = quadrature_formula.size();
+
+    WorkStream::run(this->dof_handler.begin_active(),this->dof_handler.end(),
+            std::bind(&HeatSolver<dim>::assemble_local_cell,
+                    this,
+                    std::placeholders::_1,
+                    std::placeholders::_2,
+                    std::placeholders::_3),
+            std::bind(&HeatSolver<dim>::copy_global_cell,
+                    this,
+                    std::placeholders::_1,
+                    std::ref(system)),
+            ScratchData(this->get_cell_geometry()),
+            CopyData(n_dofs, n_q_points)
+    );
+
+    stiffness_temperature = this->solution;
+    matrices_assembled = true;
+}
+
 template<int dim>
 void HeatSolver<dim>::assemble_local_cell(const typename DoFHandler<dim>::active_cell_iterator &cell,
         ScratchData &scratch_data, CopyData &copy_data) const
@@ -401,45 +516,28 @@ void HeatSolver<dim>::assemble_local_cell(const typename DoFHandler<dim>::active
     const unsigned int n_dofs = copy_data.n_dofs;
     const unsigned int n_q_points = copy_data.n_q_points;
 
-    const double gamma = cu_rho_cp * one_over_delta_time;
-
-    // The other solution values in the cell quadrature points
-    vector<Tensor<1, dim>> potential_gradients(n_q_points);
+    // The previous temperature values in the cell quadrature points
     vector<double> prev_temperatures(n_q_points);
 
-    scratch_data.fe_values.reinit(cell);
-    scratch_data.fe_values.get_function_values(this->solution, prev_temperatures);
-    scratch_data.fe_values.get_function_gradients(current_solver->solution, potential_gradients);
+    typename CellGeometry<dim>::Values& cell_values = scratch_data.cell_values;
+    cell_values.reinit(cell->active_cell_index());
+    cell_values.get_function_values(this->solution, prev_temperatures);
 
     // Local matrix assembly
     copy_data.cell_matrix = 0;
     for (unsigned int q = 0; q < n_q_points; ++q) {
-        double temperature = prev_temperatures[q];
-        double kappa = this->pq->kappa(temperature);
+        double kappa = this->pq->kappa(prev_temperatures[q]);
 
         for (unsigned int i = 0; i < n_dofs; ++i) {
             for (unsigned int j = 0; j < n_dofs; ++j) {
-                copy_data.cell_matrix(i, j) += scratch_data.fe_values.JxW(q) * (
-                        gamma * scratch_data.fe_values.shape_value(i, q) * scratch_data.fe_values.shape_value(j, q) // Mass matrix
-                        + kappa * scratch_data.fe_values.shape_grad(i, q) * scratch_data.fe_values.shape_grad(j, q) );
+                copy_data.cell_matrix(i, j) += cell_values.JxW(q) *
+                        kappa * cell_values.shape_grad(i, q) * cell_values.shape_grad(j, q);
             }
         }
     }
-
-    // Local right-hand-side vector assembly
     copy_data.cell_rhs = 0;
-    for (unsigned int q = 0; q < n_q_points; ++q) {
-        double pot_grad_squared = potential_gradients[q].norm_square();
-        double temperature = prev_temperatures[q];
-        double rho = this->pq->evaluate_resistivity(temperature);
 
-        for (unsigned int i = 0; i < n_dofs; ++i) {
-            copy_data.cell_rhs(i) += scratch_data.fe_values.JxW(q) * scratch_data.fe_values.shape_value(i, q)
-                    * (gamma * temperature + rho * pot_grad_squared);
-        }
-    }
-
-    // Obtain dof indices for updating global matrix and right-hand-side vector
+    // Obtain dof indices for updating global matrix
     cell->get_dof_indices(copy_data.dof_indices);
 }
 
@@ -472,28 +570,35 @@ template<int dim>
 void CurrentSolver<dim>::assemble() {
     require(heat_solver, "NULL heat solver can't be used!");
 
-    this->system_matrix = 0;
     this->system_rhs = 0;
 
-    LinearSystem system(&this->system_rhs, &this->system_matrix);
-    QGauss<dim> quadrature_formula(this->quadrature_degree);
-
-    const unsigned int n_dofs = this->fe.dofs_per_cell;
-    const unsigned int n_q_points = quadrature_formula.size();
-
-    WorkStream::run(this->dof_handler.begin_active(),this->dof_handler.end(),
-            std::bind(&CurrentSolver<dim>::assemble_local_cell,
-                    this,
-                    std::placeholders::_1,
-                    std::placeholders::_2,
-                    std::placeholders::_3),
-            std::bind(&CurrentSolver<dim>::copy_global_cell,
-                    this,
-                    std::placeholders::_1,
-                    std::ref(system)),
-            ScratchData(this->fe, quadrature_formula, update_gradients | update_quadrature_points | update_JxW_values),
-            CopyData(n_dofs, n_q_points)
-    );
+    // cells contribute only to the matrix that depends only on the mesh;
+    // if it is already factorized, it, together with its Dirichlet BCs, can be reused.
+    // With zero Dirichlet BC the eliminated matrix columns contribute nothing to rhs.
+    const bool reuse_matrix = this->conf->direct_solver && this->factorized && this->dirichlet_bc_value == 0;
+    if (!reuse_matrix) {
+        this->system_matrix = 0;
+
+        LinearSystem system(&this->system_rhs, &this->system_matrix);
+        QGauss<dim> quadrature_formula(this->quadrature_degree);
+
+        const unsigned int n_dofs = this->fe.dofs_per_cell;
+        const unsigned int n_q_points = quadrature_formula.size();
+
+        WorkStream::run(this->dof_handler.begin_active(),this->dof_handler.end(),
+                std::bind(&CurrentSolver<dim>::assemble_local_cell,
+                        this,
+                        std::placeholders::_1,
+                        std::placeholders::_2,
+                        std::placeholders::_3),
+                std::bind(&CurrentSolver<dim>::copy_global_cell,
+                        this,
+                        std::placeholders::_1,
+                        std::ref(system)),
+                ScratchData(this->get_cell_geometry()),
+                CopyData(n_dofs, n_q_points)
+        );
+    }
 
     this->assemble_rhs(BoundaryID::copper_surface);
     this->append_dirichlet(BoundaryID::copper_bottom, this->dirichlet_bc_value);
@@ -510,8 +615,9 @@ void CurrentSolver<dim>::assemble_local_cell(const typename DoFHandler<dim>::act
     // The previous temperature values in the cell quadrature points
     vector<double> prev_temperatures(n_q_points);
 
-    scratch_data.fe_values.reinit(cell);
-    scratch_data.fe_values.get_function_values(heat_solver->solution, prev_temperatures);
+    typename CellGeometry<dim>::Values& cell_values = scratch_data.cell_values;
+    cell_values.reinit(cell->active_cell_index());
+    cell_values.get_function_values(heat_solver->solution, prev_temperatures);
 
     // Local matrix assembly
     copy_data.cell_matrix = 0;
@@ -520,8 +626,8 @@ void CurrentSolver<dim>::assemble_local_cell(const typename DoFHandler<dim>::act
 
         for (unsigned int i = 0; i < n_dofs; ++i) {
             for (unsigned int j = 0; j < n_dofs; ++j) {
-                copy_data.cell_matrix(i, j) += scratch_data.fe_values.JxW(q) *
-                scratch_data.fe_values.shape_grad(i, q) * scratch_data.fe_values.shape_grad(j, q);
+                copy_data.cell_matrix(i, j) += cell_values.JxW(q) *
+                cell_values.shape_grad(i, q) * cell_values.shape_grad(j, q);
             }
         }
     }
@@ -558,6 +664,15 @@ void CurrentHeatSolver<dim>::setup(const double temperature) {
     heat.setup_system();
 }
 
+template<int dim>
+bool CurrentHeatSolver<dim>::update_vertices(const vector<Point<dim>>& vertices, const vector<CellData<dim>>& cells) {
+    heat.reset_matrices();
+    // heat & current solvers share the triangulation, therefore their face & cell data becomes invalid too
+    heat.clear_mesh_cache();
+    current.clear_mesh_cache();
+    return DealSolver<dim>::update_vertices(vertices, cells);
+}
+
 template<int dim>
 void CurrentHeatSolver<dim>::set_dependencies(PhysicalQuantities *pq_, const Config::Heating *conf_) {
     pq = pq_;
@@ -5,11 +5,13 @@
  *      Author: veske
  */
 
+#include <deal.II/base/work_stream.h>
 #include <deal.II/numerics/vector_tools.h>
 #include <deal.II/numerics/matrix_tools.h>
 #include <deal.II/numerics/data_out.h>
 
 #include <deal.II/lac/solver_cg.h>
+#include <deal.II/lac/solver_gmres.h>
 #include <deal.II/lac/precondition.h>
 #include <deal.II/lac/dynamic_sparsity_pattern.h>
 
@@ -18,6 +20,7 @@
 #include <deal.II/grid/grid_tools.h>
 
 #include <deal.II/dofs/dof_tools.h>
+#include <deal.II/dofs/dof_renumbering.h>
 
 #include "DealSolver.h"
 #include "Macros.h"
@@ -29,13 +32,141 @@ using namespace std;
 
 namespace femocs {
 
+/* ==================================================================
+ *  ========================= CellGeometry =========================
+ * ================================================================== */
+
+template<int dim>
+void CellGeometry<dim>::initialize(const DoFHandler<dim>& dof_handler, const Quadrature<dim>& quadrature) {
+    const FiniteElement<dim>& fe = dof_handler.get_fe();
+    n_q_points = quadrature.size();
+    n_dofs = fe.dofs_per_cell;
+
+    // values & gradients of shape functions in the reference cell are the same for all cells
+    shape_values.resize(n_q_points * n_dofs);
+    ref_grads.resize(n_q_points * n_dofs);
+    for (unsigned int q = 0; q < n_q_points; ++q)
+        for (unsigned int i = 0; i < n_dofs; ++i) {
+            shape_values[q * n_dofs + i] = fe.shape_value(i, quadrature.point(q));
+            ref_grads[q * n_dofs + i] = fe.shape_grad(i, quadrature.point(q));
+        }
+
+    vector<typename DoFHandler<dim>::active_cell_iterator> cells;
+    typename DoFHandler<dim>::active_cell_iterator cell;
+    for (cell = dof_handler.begin_active(); cell != dof_handler.end(); ++cell)
+        cells.push_back(cell);
+
+    n_cells = cells.size();
+    jxw.resize(n_cells * n_q_points);
+    inv_jacobians.resize(n_cells * n_q_points);
+    dof_indices.resize(n_cells * n_dofs);
+
+    // cells are independent, therefore only FEValues must be private for each thread
+    #pragma omp parallel
+    {
+        FEValues<dim> fe_values(fe, quadrature, update_JxW_values | update_inverse_jacobians);
+        vector<types::global_dof_index> local_dof_indices(n_dofs);
+
+        #pragma omp for
+        for (int c = 0; c < (int)n_cells; ++c) {
+            const unsigned int index = cells[c]->active_cell_index();
+            fe_values.reinit(cells[c]);
+
+            for (unsigned int q = 0; q < n_q_points; ++q) {
+                jxw[index * n_q_points + q] = fe_values.JxW(q);
+                Tensor<2,dim>& inv_jacobian = inv_jacobians[index * n_q_points + q];
+                for (int i = 0; i < dim; ++i)
+                    for (int j = 0; j < dim; ++j)
+                        inv_jacobian[i][j] = fe_values.inverse_jacobian(q)[i][j];
+            }
+
+            cells[c]->get_dof_indices(local_dof_indices);
+            std::copy(local_dof_indices.begin(), local_dof_indices.end(), dof_indices.begin() + index * n_dofs);
+        }
+    }
+}
+
+template<int dim>
+void CellGeometry<dim>::clear() {
+    n_cells = 0;
+    jxw = vector<double>();
+    inv_jacobians = vector<Tensor<2,dim>>();
+    dof_indices = vector<types::global_dof_index>();
+}
+
+template<int dim>
+CellGeometry<dim>::Values::Values(const CellGeometry<dim>& g) :
+    geometry(&g), cell(0), offset(0)
+{}
+
+template<int dim>
+void CellGeometry<dim>::Values::reinit(const unsigned int cell_index, const bool with_gradients) {
+    const unsigned int n_q_points = geometry->n_q_points;
+    const unsigned int n_dofs = geometry->n_dofs;
+
+    cell = cell_index;
+    offset = cell * n_q_points;
+    if (!with_gradients) return;
+
+    // real-space gradient is the reference gradient transformed with the transpose of inverse Jacobian
+    shape_grads.resize(n_q_points * n_dofs);
+    for (unsigned int q = 0; q < n_q_points; ++q) {
+        const Tensor<2,dim>& inv_jacobian = geometry->inv_jacobians[offset + q];
+        for (unsigned int i = 0; i < n_dofs; ++i) {
+            const Tensor<1,dim>& ref_grad = geometry->ref_grads[q * n_dofs + i];
+            Tensor<1,dim>& grad = shape_grads[q * n_dofs + i];
+            for (int d = 0; d < dim; ++d) {
+                grad[d] = 0;
+                for (int k = 0; k < dim; ++k)
+                    grad[d] += ref_grad[k] * inv_jacobian[k][d];
+            }
+        }
+    }
+}
+
+template<int dim>
+void CellGeometry<dim>::Values::get_function_values(const Vector<double>& fe_function, vector<double>& values) const {
+    const unsigned int n_q_points = geometry->n_q_points;
+    const unsigned int n_dofs = geometry->n_dofs;
+    const types::global_dof_index* dofs = &geometry->dof_indices[cell * n_dofs];
+
+    values.resize(n_q_points);
+    for (unsigned int q = 0; q < n_q_points; ++q) {
+        values[q] = 0;
+        for (unsigned int i = 0; i < n_dofs; ++i)
+            values[q] += fe_function[dofs[i]] * shape_value(i, q);
+    }
+}
+
+template<int dim>
+void CellGeometry<dim>::Values::get_function_gradients(const Vector<double>& fe_function,
+        vector<Tensor<1,dim>>& gradients) const
+{
+    const unsigned int n_q_points = geometry->n_q_points;
+    const unsigned int n_dofs = geometry->n_dofs;
+    const types::global_dof_index* dofs = &geometry->dof_indices[cell * n_dofs];
+
+    gradients.resize(n_q_points);
+    for (unsigned int q = 0; q < n_q_points; ++q) {
+        gradients[q] = 0;
+        for (unsigned int i = 0; i < n_dofs; ++i)
+            gradients[q] += fe_function[dofs[i]] * shape_grad(i, q);
+    }
+}
+
+/* ==================================================================
+ *  ========================== DealSolver ==========================
+ * ================================================================== */
+
 template<int dim>
 DealSolver<dim>::DealSolver() :
-        dirichlet_bc_value(0), tria(&triangulation), fe(shape_degree), dof_handler(triangulation) {}
+        dirichlet_bc_value(0), tria(&triangulation), fe(shape_degree), dof_handler(triangulation),
+        factorized(false), amg_initialized(false), amg_n_steps(0) {}
 
 template<int dim>
 DealSolver<dim>::DealSolver(Triangulation<dim> *tr) :
-        dirichlet_bc_value(0), tria(tr), fe(shape_degree), dof_handler(*tr) {}
+        dirichlet_bc_value(0), tria(tr), fe(shape_degree), dof_handler(*tr),
+        factorized(false), amg_initialized(false), amg_n_steps(0) {}
 
 template<int dim>
 DealSolver<dim>::LinearSystem::LinearSystem(Vector<double>* rhs, SparseMatrix<double>* matrix) :
@@ -43,14 +174,8 @@ DealSolver<dim>::LinearSystem::LinearSystem(Vector<double>* rhs, SparseMatrix<do
 {}
 
 template<int dim>
-DealSolver<dim>::ScratchData::ScratchData (const FiniteElement<dim>  &fe,
-        const Quadrature<dim> &quadrature, const UpdateFlags ul) :
-    fe_values(fe, quadrature, ul)
-{}
-
-template<int dim>
-DealSolver<dim>::ScratchData::ScratchData (const ScratchData &sd):
-    fe_values(sd.fe_values.get_fe(), sd.fe_values.get_quadrature(), sd.fe_values.get_update_flags())
+DealSolver<dim>::ScratchData::ScratchData (const CellGeometry<dim> &geometry) :
+    cell_values(geometry)
 {}
 
 template<int dim>
@@ -184,6 +309,7 @@ bool DealSolver<dim>::import_mesh(const string &file_name) {
     gi.attach_triangulation(triangulation);
     gi.read_msh(infile);
 
+    clear_mesh_cache();
     mark_mesh();
     return true;
 }
@@ -204,10 +330,65 @@ bool DealSolver<dim>::import_mesh(vector<Point<dim>> vertices, vector<CellData<d
         return false;
     }
 
+    clear_mesh_cache();
     mark_mesh();
     return true;
 }
 
+template<int dim>
+bool DealSolver<dim>::import_compact_mesh(const vector<Point<dim>>& vertices, const vector<CellData<dim>>& cells) {
+    try {
+        // Clean previous mesh
+        triangulation.clear();
+        // Create new mesh
+        triangulation.create_triangulation(vertices, cells, SubCellData());
+    } catch (exception &exc) {
+        return false;
+    }
+
+    clear_mesh_cache();
+    mark_mesh();
+    return true;
+}
+
+template<int dim>
+bool DealSolver<dim>::update_vertices(const vector<Point<dim>>& vertices, const vector<CellData<dim>>& cells) {
+    static constexpr int n_verts_per_elem = GeometryInfo<dim>::vertices_per_cell;
+
+    // number the used vertices in the same way as GridTools::delete_unused_vertices does
+    vector<int> vertex_map(vertices.size(), -1);
+    for (const CellData<dim>& cell : cells)
+        for (int i = 0; i < n_verts_per_elem; ++i)
+            vertex_map[cell.vertices[i]] = 0;
+
+    unsigned int n_used = 0;
+    for (int& v : vertex_map)
+        if (v == 0) v = n_used++;
+
+    if (n_used != triangulation.n_used_vertices())
+        return false;
+
+    vector<Point<dim>> used_vertices(n_used);
+    for (size_t i = 0; i < vertices.size(); ++i)
+        if (vertex_map[i] >= 0)
+            used_vertices[vertex_map[i]] = vertices[i];
+
+    vector<bool> vertex_moved(n_used, false);
+    typename Triangulation<dim>::active_cell_iterator cell;
+    for (cell = triangulation.begin_active(); cell != triangulation.end(); ++cell)
+        for (int i = 0; i < n_verts_per_elem; ++i) {
+            const unsigned int v = cell->vertex_index(i);
+            if (!vertex_moved[v]) {
+                cell->vertex(i) = used_vertices[v];
+                vertex_moved[v] = true;
+            }
+        }
+
+    // face & cell geometries have changed
+    clear_mesh_cache();
+    return true;
+}
+
 template<int dim>
 void DealSolver<dim>::write_vtk(ofstream& out) const {
     DataOut<dim> data_out;
@@ -227,21 +408,11 @@ void DealSolver<dim>::write_msh(ofstream& out) const {
 
 template<int dim>
 void DealSolver<dim>::export_surface_centroids(Medium& medium) const {
-    const int n_faces_per_cell = GeometryInfo<dim>::faces_per_cell;
-    typename DoFHandler<dim>::active_cell_iterator cell;
-
-    unsigned int n_nodes = 0;
-    for (cell = dof_handler.begin_active(); cell != dof_handler.end(); ++cell)
-        for (int f = 0; f < n_faces_per_cell; ++f)
-            if (cell->face(f)->boundary_id() == BoundaryID::copper_surface)
-                n_nodes++;
-
-    medium.reserve(n_nodes);
+    const vector<BoundaryFace>& faces = get_boundary_faces(BoundaryID::copper_surface);
 
-    for (cell = dof_handler.begin_active(); cell != dof_handler.end(); ++cell)
-        for (int f = 0; f < n_faces_per_cell; ++f)
-            if (cell->face(f)->boundary_id() == BoundaryID::copper_surface)
-                medium.append( femocs::Point3(cell->face(f)->center()) );
+    medium.reserve(faces.size());
+    for (const BoundaryFace& face : faces)
+        medium.append( femocs::Point3(face.centroid) );
 }
 
 template<int dim>
@@ -283,20 +454,22 @@ void DealSolver<dim>::export_solution_grad(vector<Tensor<1, dim>> &grads) const
     require(n_verts == vertex2cell.size(), "Mismatch between #vertices and vertex2cell size: "
             + d2s(n_verts) + " vs " + d2s(vertex2cell.size()));
 
-    QGauss<dim> quadrature_formula(this->quadrature_degree);
-    FEValues<dim> fe_values(this->fe, quadrature_formula, update_gradients);
-
-    vector<Tensor<1, dim>> solution_gradients(quadrature_formula.size());
+    const CellGeometry<dim>& geometry = get_cell_geometry();
     grads.resize(n_verts);
 
-    for (unsigned i = 0; i < n_verts; i++) {
-        // Using DoFAccessor (groups.google.com/forum/?hl=en-GB#!topic/dealii/azGWeZrIgR0)
-        // NB: only works without refinement !!!
-        typename DoFHandler<dim>::active_cell_iterator dof_cell(tria, 0, vertex2cell[i], &dof_handler);
-
-        fe_values.reinit(dof_cell);
-        fe_values.get_function_gradients(this->solution, solution_gradients);
-        grads[i] = -1.0 * solution_gradients.at(vertex2node[i]);
+    // vertices are independent, therefore only cell values must be private for each thread
+    #pragma omp parallel
+    {
+        typename CellGeometry<dim>::Values cell_values(geometry);
+        vector<Tensor<1, dim>> solution_gradients(geometry.n_quadrature_points());
+
+        #pragma omp for
+        for (int i = 0; i < n_verts; i++) {
+            // NB: only works without refinement, as then the cell index equals to the active cell index !!!
+            cell_values.reinit(vertex2cell[i]);
+            cell_values.get_function_gradients(this->solution, solution_gradients);
+            grads[i] = -1.0 * solution_gradients[vertex2node[i]];
+        }
     }
 }
 
@@ -343,42 +516,71 @@ void DealSolver<dim>::calc_vertex2dof() {
 template<int dim>
 void DealSolver<dim>::calc_dof_volumes() {
     QGauss<dim> quadrature_formula(quadrature_degree);
-    FEValues<dim> fe_values(fe, quadrature_formula,  update_values | update_quadrature_points | update_JxW_values);
-    vector<types::global_dof_index> local_dof_indices(fe.dofs_per_cell);
 
     // reset volumes
     dof_volume.resize(size());
     std::fill(dof_volume.begin(), dof_volume.end(), 0);
 
-    // Iterate over all cells
-    typename DoFHandler<dim>::active_cell_iterator cell;
-    for (cell = dof_handler.begin_active(); cell != dof_handler.end(); ++cell) {
-        fe_values.reinit(cell);
-        cell->get_dof_indices(local_dof_indices);
-
-        // Iterate through quadrature points to integrate
-        for (unsigned q = 0; q < quadrature_formula.size(); ++q) {
-            //iterate through local dofs
-            for (unsigned int i = 0; i < fe.dofs_per_cell; ++i)
-                dof_volume[local_dof_indices[i]] +=  fe_values.JxW(q) * fe_values.shape_value(i, q);
-        }
+    WorkStream::run(dof_handler.begin_active(), dof_handler.end(),
+            std::bind(&DealSolver<dim>::calc_dof_volumes_local_cell,
+                    this,
+                    std::placeholders::_1,
+                    std::placeholders::_2,
+                    std::placeholders::_3),
+            std::bind(&DealSolver<dim>::copy_dof_volumes,
+                    this,
+                    std::placeholders::_1),
+            ScratchData(get_cell_geometry()),
+            CopyData(fe.dofs_per_cell, quadrature_formula.size())
+    );
+}
+
+template<int dim>
+void DealSolver<dim>::calc_dof_volumes_local_cell(const typename DoFHandler<dim>::active_cell_iterator &cell,
+        ScratchData &scratch_data, CopyData &copy_data) const
+{
+    typename CellGeometry<dim>::Values& cell_values = scratch_data.cell_values;
+    cell_values.reinit(cell->active_cell_index(), false);
+
+    // Iterate through quadrature points to integrate
+    copy_data.cell_rhs = 0;
+    for (unsigned q = 0; q < copy_data.n_q_points; ++q) {
+        //iterate through local dofs
+        for (unsigned int i = 0; i < copy_data.n_dofs; ++i)
+            copy_data.cell_rhs(i) += cell_values.JxW(q) * cell_values.shape_value(i, q);
     }
+
+    cell->get_dof_indices(copy_data.dof_indices);
 }
 
 template<int dim>
-void DealSolver<dim>::setup_system() {
+void DealSolver<dim>::copy_dof_volumes(const CopyData &copy_data) {
+    for (unsigned int i = 0; i < copy_data.n_dofs; ++i)
+        dof_volume[copy_data.dof_indices[i]] += copy_data.cell_rhs(i);
+}
+
+template<int dim>
+void DealSolver<dim>::setup_system(const bool with_matrix) {
     require(tria->n_used_vertices() > 0, "Can't setup system with no mesh!");
 
     this->dof_handler.distribute_dofs(this->fe);
+    // minimize the bandwidth of system matrix to improve the cache usage while solving
+    DoFRenumbering::Cuthill_McKee(this->dof_handler);
     this->boundary_values.clear();
+    this->clear_mesh_cache();
 
     const unsigned int n_dofs = size();
 
-    DynamicSparsityPattern dsp(n_dofs);
-    DoFTools::make_sparsity_pattern(this->dof_handler, dsp);
-    this->sparsity_pattern.copy_from(dsp);
+    if (with_matrix) {
+        DynamicSparsityPattern dsp(n_dofs);
+        DoFTools::make_sparsity_pattern(this->dof_handler, dsp);
+        this->sparsity_pattern.copy_from(dsp);
+        this->system_matrix.reinit(this->sparsity_pattern);
+    } else {
+        this->system_matrix.clear();
+        this->sparsity_pattern.reinit(0, 0, 0);
+    }
 
-    this->system_matrix.reinit(this->sparsity_pattern);
     this->system_rhs.reinit(n_dofs);
     this->solution.reinit(n_dofs);
     this->solution = this->dirichlet_bc_value;
@@ -387,18 +589,12 @@ void DealSolver<dim>::setup_system() {
 }
 
 template<int dim>
-void DealSolver<dim>::assemble_rhs(const int bid) {
-
-    QGauss<dim-1> face_quadrature_formula(this->quadrature_degree);
-    FEFaceValues<dim> fe_face_values(this->fe, face_quadrature_formula,
-            update_values | update_quadrature_points | update_JxW_values);
-
-    const unsigned int dofs_per_cell = this->fe.dofs_per_cell;
-    const unsigned int n_face_q_points = face_quadrature_formula.size();
-
-    Vector<double> cell_rhs(dofs_per_cell);
-    vector<types::global_dof_index> local_dof_indices(dofs_per_cell);
+const vector<typename DealSolver<dim>::BoundaryFace>& DealSolver<dim>::get_boundary_faces(const int bid) const {
+    auto cached = boundary_faces.find(bid);
+    if (cached != boundary_faces.end())
+        return cached->second;
 
+    vector<BoundaryFace>& faces = boundary_faces[bid];
     typename DoFHandler<dim>::active_cell_iterator cell;
 
     // Iterate over all cells (quadrangles in 2D, hexahedra in 3D) of the mesh
@@ -406,27 +602,70 @@ void DealSolver<dim>::assemble_rhs(const int bid) {
     for (cell = this->dof_handler.begin_active(); cell != this->dof_handler.end(); ++cell) {
         // Loop over all faces (lines in 2D, quadrangles in 3D) of the cell
         for (unsigned int f = 0; f < GeometryInfo<dim>::faces_per_cell; ++f) {
-            // Apply boundary condition at faces on top of vacuum domain
-            if (cell->face(f)->at_boundary() && cell->face(f)->boundary_id() == bid) {
-                fe_face_values.reinit(cell, f);
-                double bc_value = get_face_bc(boundary_face_index++);
-
-                // Compose local rhs update
-                cell_rhs = 0;
-                for (unsigned int q = 0; q < n_face_q_points; ++q) {
-                    for (unsigned int i = 0; i < dofs_per_cell; ++i) {
-                        cell_rhs(i) += fe_face_values.shape_value(i, q)
-                                * bc_value * fe_face_values.JxW(q);
-                    }
-                }
-
-                // Add the current cell rhs entries to the system rhs
-                cell->get_dof_indices(local_dof_indices);
-                for (unsigned int i = 0; i < dofs_per_cell; ++i)
-                    this->system_rhs(local_dof_indices[i]) += cell_rhs(i);
-            }
+            if (cell->face(f)->at_boundary() && cell->face(f)->boundary_id() == bid)
+                faces.push_back({cell, f, boundary_face_index++, cell->face(f)->center()});
+        }
+    }
+
+    // without distributed dofs only the geometry of faces is available
+    if (dof_handler.n_dofs() == 0)
+        return faces;
+
+    // with constant BC value on a face, the face integral reduces to the integrals of shape functions
+    QGauss<dim-1> face_quadrature_formula(this->quadrature_degree);
+    const int n_faces = faces.size();
+
+    #pragma omp parallel
+    {
+        FEFaceValues<dim> fe_face_values(this->fe, face_quadrature_formula, update_values | update_JxW_values);
+        const unsigned int dofs_per_cell = this->fe.dofs_per_cell;
+        const unsigned int n_face_q_points = face_quadrature_formula.size();
+
+        #pragma omp for
+        for (int i = 0; i < n_faces; ++i) {
+            BoundaryFace& face = faces[i];
+            fe_face_values.reinit(face.cell, face.face);
+
+            face.dof_indices.resize(dofs_per_cell);
+            face.cell->get_dof_indices(face.dof_indices);
+
+            face.shape_integrals = vector<double>(dofs_per_cell, 0);
+            for (unsigned int q = 0; q < n_face_q_points; ++q)
+                for (unsigned int j = 0; j < dofs_per_cell; ++j)
+                    face.shape_integrals[j] += fe_face_values.shape_value(j, q) * fe_face_values.JxW(q);
         }
     }
+
+    return faces;
+}
+
+template<int dim>
+const CellGeometry<dim>& DealSolver<dim>::get_cell_geometry() const {
+    if (cell_geometry.empty())
+        cell_geometry.initialize(dof_handler, QGauss<dim>(quadrature_degree));
+    return cell_geometry;
+}
+
+template<int dim>
+void DealSolver<dim>::clear_mesh_cache() {
+    boundary_faces.clear();
+    cell_geometry.clear();
+    if (factorized) {
+        direct_solver.clear();
+        factorized = false;
+    }
+    amg_initialized = false;
+}
+
+template<int dim>
+void DealSolver<dim>::assemble_rhs(const int bid) {
+    const vector<BoundaryFace>& faces = get_boundary_faces(bid);
+
+    for (const BoundaryFace& face : faces) {
+        const double bc_value = get_face_bc(face.index);
+        for (unsigned int i = 0; i < face.dof_indices.size(); ++i)
+            this->system_rhs(face.dof_indices[i]) += bc_value * face.shape_integrals[i];
+    }
 }
 
 template<int dim>
@@ -440,11 +679,28 @@ void DealSolver<dim>::apply_dirichlet() {
 }
 
 template<int dim>
-int DealSolver<dim>::solve_cg(int max_iter, double tol, double ssor_param) {
+int DealSolver<dim>::solve_cg(int max_iter, double tol, double ssor_param, bool use_amg) {
     SolverControl solver_control(max_iter, tol);
     SolverCG<> solver(solver_control);
+    return solve_iterative(solver, solver_control, ssor_param, use_amg);
+}
+
+template<int dim> template<typename Solver>
+int DealSolver<dim>::solve_iterative(Solver& solver, const SolverControl& solver_control, double ssor_param, bool use_amg) {
     try {
-        if (ssor_param > 0.0) {
+        if (use_amg) {
+            bool reused = init_amg();
+            try {
+                solver.solve(system_matrix, solution, system_rhs, amg);
+            } catch (exception &exc) {
+                // outdated hierarchy might be the reason of failure; retry with the new one
+                if (!reused) throw;
+                amg_initialized = false;
+                reused = init_amg();
+                solver.solve(system_matrix, solution, system_rhs, amg);
+            }
+            check_amg(solver_control.last_step(), reused);
+        } else if (ssor_param > 0.0) {
             PreconditionSSOR<> preconditioner;
             preconditioner.initialize(system_matrix, ssor_param);
             solver.solve(system_matrix, solution, system_rhs, preconditioner);
@@ -457,6 +713,44 @@ int DealSolver<dim>::solve_cg(int max_iter, double tol, double ssor_param) {
     }
 }
 
+template<int dim>
+bool DealSolver<dim>::init_amg() {
+    if (amg_initialized) return true;
+    amg.initialize(system_matrix);
+    amg_initialized = true;
+    return false;
+}
+
+template<int dim>
+void DealSolver<dim>::check_amg(const int n_steps, const bool reused) {
+    if (!reused)
+        amg_n_steps = n_steps;
+    else if (n_steps > 2 * amg_n_steps + 5)
+        amg_initialized = false;
+}
+
+template<int dim>
+int DealSolver<dim>::solve_direct() {
+    try {
+        if (!factorized) {
+            direct_solver.initialize(system_matrix);
+            factorized = true;
+        }
+        direct_solver.vmult(solution, system_rhs);
+        return 0;
+    } catch (exception &exc) {
+        factorized = false;
+        return -1;
+    }
+}
+
+template<int dim>
+int DealSolver<dim>::solve_gmres(int max_iter, double tol, double ssor_param, bool use_amg) {
+    SolverControl solver_control(max_iter, tol);
+    SolverGMRES<> solver(solver_control);
+    return solve_iterative(solver, solver_control, ssor_param, use_amg);
+}
+
 template<int dim>
 void DealSolver<dim>::mark_boundary(int top, int bottom, int sides, int other) {
     static constexpr double eps = 1e-6;
@@ -517,6 +811,7 @@ void DealSolver<dim>::mark_boundary(int top, int bottom, int sides, int other) {
     }
 }
 
+template class CellGeometry<3>;
 template class DealSolver<3>;
 
 } /* namespace femocs */
@@ -29,10 +29,10 @@ bool FileWriter::first_line(ofstream &out) const {
     return out.tellp() == 0;
 }
 
-void FileWriter::write(const string &file_name, unsigned int flags) {
+int FileWriter::write(const string &file_name, unsigned int flags) {
     bool force = flags & FileIO::force;
     if (!force && !write_time())
-        return;
+        return 0;
 
     bool update = ! (flags & FileIO::no_update);
     bool append = flags & FileIO::append;
@@ -40,7 +40,7 @@ void FileWriter::write(const string &file_name, unsigned int flags) {
     string ftype = get_file_type(file_name);
     if (!valid_extension(ftype)) {
         write_verbose_msg("Unimplemented file type: " + ftype);
-        return;
+        return 1;
     }
 
     ofstream outfile;
@@ -70,9 +70,16 @@ void FileWriter::write(const string &file_name, unsigned int flags) {
         write_restart(outfile);
     else if (ftype == "ckx")
         write_ckx(outfile);
+    else if (ftype == "fmesh")
+        write_fmesh(outfile);
 
     outfile.close();
+    if (outfile.fail()) {
+        write_verbose_msg("Writing to " + file_name + " failed!");
+        return 1;
+    }
     if (update) last_write_time = GLOBALS.TIME;
+    return 0;
 }
 
 void FileWriter::write_xyz(ofstream &out) const {
@@ -111,6 +118,10 @@ void FileWriter::write_ckx(ofstream &out) const {
     require(false, "FileWriter::write_ckx not implemented!");
 }
 
+void FileWriter::write_fmesh(ofstream &out) const {
+    require(false, "FileWriter::write_fmesh not implemented!");
+}
+
 void FileWriter::write_dat(ofstream &out) const {
     // In case of empty file, write first data header
     if (first_line(out))
@@ -153,6 +153,46 @@ vector<int> get_sort_indices(const vector<int> &v, const string& direction) {
     return idx;
 }
 
+uint64_t hilbert_index(const double x, const double y, const double z) {
+    static constexpr int n_bits = 21;
+    static constexpr uint32_t n_cells = 1u << n_bits;
+
+    uint32_t X[3];
+    const double coords[3] = {x, y, z};
+    for (int i = 0; i < 3; ++i)
+        X[i] = (uint32_t) min(n_cells - 1.0, max(0.0, coords[i] * n_cells));
+
+    // transform the coordinates into the transposed Hilbert index (J.Skilling, AIP Conf. Proc. 707, 2004)
+    for (uint32_t Q = 1u << (n_bits - 1); Q > 1; Q >>= 1) {
+        const uint32_t P = Q - 1;
+        for (int i = 0; i < 3; ++i)
+            if (X[i] & Q)
+                X[0] ^= P;
+            else {
+                const uint32_t t = (X[0] ^ X[i]) & P;
+                X[0] ^= t;
+                X[i] ^= t;
+            }
+    }
+
+    // Gray encode
+    X[1] ^= X[0];
+    X[2] ^= X[1];
+    uint32_t t = 0;
+    for (uint32_t Q = 1u << (n_bits - 1); Q > 1; Q >>= 1)
+        if (X[2] & Q) t ^= Q - 1;
+    for (int i = 0; i < 3; ++i)
+        X[i] ^= t;
+
+    // interleave the bits of transposed index
+    uint64_t index = 0;
+    for (int b = n_bits - 1; b >= 0; --b)
+        for (int i = 0; i < 3; ++i)
+            index = (index << 1) | ((X[i] >> b) & 1);
+
+    return index;
+}
+
 int vector_sum(const vector<bool> &v) {
     return accumulate(v.begin(), v.end(), 0);
 }
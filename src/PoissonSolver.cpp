@@ -3,6 +3,11 @@
 #include <deal.II/grid/grid_tools.h>
 #include <deal.II/numerics/data_out.h>
 #include <deal.II/base/work_stream.h>
+#include <deal.II/base/aligned_vector.h>
+#include <deal.II/lac/constraint_matrix.h>
+#include <deal.II/lac/precondition.h>
+#include <deal.II/lac/solver_cg.h>
+#include <deal.II/matrix_free/fe_evaluation.h>
 
 #include "PoissonSolver.h"
 #include "Globals.h"
@@ -35,6 +40,111 @@ public:
 };
 // ----------------------------------------------------------------------------
 
+template<int dim, int fe_degree>
+void LaplaceOperator<dim, fe_degree>::initialize(const DoFHandler<dim>& dof_handler) {
+    typename MatrixFree<dim, double>::AdditionalData additional_data;
+    additional_data.tasks_parallel_scheme = MatrixFree<dim, double>::AdditionalData::partition_color;
+    additional_data.mapping_update_flags = update_gradients | update_JxW_values;
+
+    // Dirichlet BCs are handled by the operator itself
+    ConstraintMatrix no_constraints;
+    no_constraints.close();
+
+    data.reinit(dof_handler, no_constraints, QGauss<1>(fe_degree + 1), additional_data);
+    n_dofs = dof_handler.n_dofs();
+    free_src.reinit(n_dofs);
+}
+
+template<int dim, int fe_degree>
+void LaplaceOperator<dim, fe_degree>::set_constrained_dofs(const map<types::global_dof_index, double>& boundary_values) {
+    constrained_dofs.clear();
+    constrained_dofs.reserve(boundary_values.size());
+    for (const auto& bv : boundary_values)
+        constrained_dofs.push_back(bv.first);
+}
+
+template<int dim, int fe_degree>
+void LaplaceOperator<dim, fe_degree>::local_apply(const MatrixFree<dim, double>& data, Vector<double>& dst,
+        const Vector<double>& src, const pair<unsigned int, unsigned int>& cell_range) const
+{
+    FEEvaluation<dim, fe_degree> phi(data);
+
+    for (unsigned int cell = cell_range.first; cell < cell_range.second; ++cell) {
+        phi.reinit(cell);
+        phi.read_dof_values(src);
+        phi.evaluate(false, true);
+        for (unsigned int q = 0; q < phi.n_q_points; ++q)
+            phi.submit_gradient(phi.get_gradient(q), q);
+        phi.integrate(false, true);
+        phi.distribute_local_to_global(dst);
+    }
+}
+
+template<int dim, int fe_degree>
+void LaplaceOperator<dim, fe_degree>::local_diagonal(const MatrixFree<dim, double>& data, Vector<double>& dst,
+        const unsigned int&, const pair<unsigned int, unsigned int>& cell_range) const
+{
+    FEEvaluation<dim, fe_degree> phi(data);
+    AlignedVector<VectorizedArray<double>> diagonal(phi.dofs_per_cell);
+
+    for (unsigned int cell = cell_range.first; cell < cell_range.second; ++cell) {
+        phi.reinit(cell);
+
+        // apply operator to unit vectors to extract the diagonal of cell matrix
+        for (unsigned int i = 0; i < phi.dofs_per_cell; ++i) {
+            for (unsigned int j = 0; j < phi.dofs_per_cell; ++j)
+                phi.submit_dof_value(make_vectorized_array(0.0), j);
+            phi.submit_dof_value(make_vectorized_array(1.0), i);
+
+            phi.evaluate(false, true);
+            for (unsigned int q = 0; q < phi.n_q_points; ++q)
+                phi.submit_gradient(phi.get_gradient(q), q);
+            phi.integrate(false, true);
+            diagonal[i] = phi.get_dof_value(i);
+        }
+
+        for (unsigned int i = 0; i < phi.dofs_per_cell; ++i)
+            phi.submit_dof_value(diagonal[i], i);
+        phi.distribute_local_to_global(dst);
+    }
+}
+
+template<int dim, int fe_degree>
+void LaplaceOperator<dim, fe_degree>::apply(Vector<double>& dst, const Vector<double>& src) const {
+    dst = 0;
+    data.cell_loop(&LaplaceOperator::local_apply, this, dst, src);
+}
+
+template<int dim, int fe_degree>
+void LaplaceOperator<dim, fe_degree>::vmult(Vector<double>& dst, const Vector<double>& src) const {
+    free_src = src;
+    for (types::global_dof_index dof : constrained_dofs)
+        free_src(dof) = 0;
+
+    apply(dst, free_src);
+
+    for (types::global_dof_index dof : constrained_dofs)
+        dst(dof) = src(dof);
+}
+
+template<int dim, int fe_degree>
+void LaplaceOperator<dim, fe_degree>::calc_inverse_diagonal(Vector<double>& inverse_diagonal) const {
+    inverse_diagonal.reinit(n_dofs);
+    const unsigned int dummy = 0;
+    data.cell_loop(&LaplaceOperator::local_diagonal, this, inverse_diagonal, dummy);
+
+    for (types::global_dof_index dof : constrained_dofs)
+        inverse_diagonal(dof) = 1.0;
+
+    for (types::global_dof_index i = 0; i < n_dofs; ++i)
+        if (inverse_diagonal(i) > 0)
+            inverse_diagonal(i) = 1.0 / inverse_diagonal(i);
+        else
+            inverse_diagonal(i) = 1.0;
+}
+
+// ----------------------------------------------------------------------------
+
 template<int dim>
 PoissonSolver<dim>::PoissonSolver() : DealSolver<dim>(),
         conf(NULL), interpolator(NULL), applied_field(0), applied_potential(0)
@@ -153,8 +263,13 @@ double PoissonSolver<dim>::get_face_bc(const unsigned int face) const {
 }
 
 template<int dim>
-void PoissonSolver<dim>::setup(const double field, const double potential) {
-    DealSolver<dim>::setup_system();
+void PoissonSolver<dim>::setup(const double field, const double potential, const bool full_setup) {
+    require(conf, "NULL conf can't be used!");
+    if (full_setup)
+        DealSolver<dim>::setup_system(!conf->matrix_free);
+    // cell geometries must be updated also after moving the mesh vertices
+    if (conf->matrix_free)
+        laplace_operator.initialize(this->dof_handler);
     applied_field = field;
     applied_potential = potential;
 }
@@ -165,18 +280,20 @@ void PoissonSolver<dim>::assemble(const bool full_run) {
     require(conf->anode_BC == "neumann" || conf->anode_BC == "dirichlet",
             "Unimplemented anode BC: " + conf->anode_BC);
 
-    if (full_run) this->system_matrix = 0;
+    // in matrix-free mode the operator is evaluated on the fly, therefore only rhs is assembled
+    const bool assemble_matrix = full_run && !conf->matrix_free;
+    if (assemble_matrix) this->system_matrix = 0;
     this->system_rhs = 0;
 
     if (conf->anode_BC == "neumann") {
         if (full_run) {
-            assemble_parallel();
+            if (assemble_matrix) assemble_parallel();
             this->append_dirichlet(BoundaryID::copper_surface, this->dirichlet_bc_value);
         }
         this->assemble_rhs(BoundaryID::vacuum_top);
     } else {
         if (full_run) {
-            assemble_parallel();
+            if (assemble_matrix) assemble_parallel();
             this->append_dirichlet(BoundaryID::copper_surface, this->dirichlet_bc_value);
             this->append_dirichlet(BoundaryID::vacuum_top, applied_potential);
         }
@@ -193,7 +310,56 @@ void PoissonSolver<dim>::assemble(const bool full_run) {
             this->charge_density[dof] /= this->dof_volume[dof];
         }
     }
-    if (full_run) this->apply_dirichlet();
+    if (conf->matrix_free) apply_dirichlet_matrix_free();
+    else if (full_run) this->apply_dirichlet();
+}
+
+template<int dim>
+void PoissonSolver<dim>::apply_dirichlet_matrix_free() {
+    const unsigned int n_dofs = this->size();
+    laplace_operator.set_constrained_dofs(this->boundary_values);
+
+    // move the contribution of fixed dofs to the rhs of free dofs
+    Vector<double> fixed_values(n_dofs), fixed_contribution(n_dofs);
+    for (const auto& bv : this->boundary_values)
+        fixed_values(bv.first) = bv.second;
+    laplace_operator.apply(fixed_contribution, fixed_values);
+    this->system_rhs -= fixed_contribution;
+
+    // the rows of fixed dofs are identity in the operator
+    for (const auto& bv : this->boundary_values) {
+        this->system_rhs(bv.first) = bv.second;
+        this->solution(bv.first) = bv.second;
+    }
+}
+
+template<int dim>
+int PoissonSolver<dim>::solve() {
+    if (conf->matrix_free)
+        return solve_matrix_free();
+    return this->solve_cg(conf->n_cg, conf->cg_tolerance, conf->ssor_param, conf->precond == "amg");
+}
+
+template<int dim>
+int PoissonSolver<dim>::solve_matrix_free() {
+    typedef LaplaceOperator<dim, DealSolver<dim>::shape_degree> Operator;
+    typedef PreconditionChebyshev<Operator, Vector<double>> Preconditioner;
+
+    typename Preconditioner::AdditionalData additional_data;
+    additional_data.degree = chebyshev_degree;
+    additional_data.smoothing_range = chebyshev_range;
+    laplace_operator.calc_inverse_diagonal(additional_data.matrix_diagonal_inverse);
+
+    Preconditioner preconditioner;
+    SolverControl solver_control(conf->n_cg, conf->cg_tolerance);
+    SolverCG<> solver(solver_control);
+    try {
+        preconditioner.initialize(laplace_operator, additional_data);
+        solver.solve(laplace_operator, this->solution, this->system_rhs, preconditioner);
+        return solver_control.last_step();
+    } catch (exception &exc) {
+        return -1 * solver_control.last_step();
+    }
 }
 
 template<int dim>
@@ -214,7 +380,7 @@ void PoissonSolver<dim>::assemble_parallel() {
                     this,
                     std_cxx11::_1,
                     std_cxx11::ref(system)),
-            ScratchData(this->fe, quadrature_formula, update_gradients | update_quadrature_points | update_JxW_values),
+            ScratchData(this->get_cell_geometry()),
             CopyData(n_dofs, n_q_points)
     );
 }
@@ -226,15 +392,16 @@ void PoissonSolver<dim>::assemble_local_cell(const typename DoFHandler<dim>::act
     const unsigned int n_dofs = copy_data.n_dofs;
     const unsigned int n_q_points = copy_data.n_q_points;
 
-    scratch_data.fe_values.reinit(cell);
+    typename CellGeometry<dim>::Values& cell_values = scratch_data.cell_values;
+    cell_values.reinit(cell->active_cell_index());
 
     // Local matrix assembly
     copy_data.cell_matrix = 0;
     for (unsigned int q = 0; q < n_q_points; ++q) {
         for (unsigned int i = 0; i < n_dofs; ++i) {
             for (unsigned int j = 0; j < n_dofs; ++j) {
-                copy_data.cell_matrix(i, j) += scratch_data.fe_values.JxW(q) *
-                scratch_data.fe_values.shape_grad(i, q) * scratch_data.fe_values.shape_grad(j, q);
+                copy_data.cell_matrix(i, j) += cell_values.JxW(q) *
+                cell_values.shape_grad(i, q) * cell_values.shape_grad(j, q);
             }
         }
     }
@@ -259,6 +426,7 @@ void PoissonSolver<dim>::write_vtk(ofstream& out) const {
     data_out.write_vtk(out);
 }
 
+template class LaplaceOperator<3, 1> ;
 template class PoissonSolver<3> ;
 
 } // namespace femocs
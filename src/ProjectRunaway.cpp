@@ -6,6 +6,14 @@
  */
 
 #include <omp.h>
+#include <float.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdint>
+#include <iomanip>
+#include <array>
+#include <algorithm>
 
 #include "ProjectRunaway.h"
 #include "Macros.h"
@@ -18,9 +26,11 @@ namespace femocs {
 
 ProjectRunaway::ProjectRunaway(AtomReader &reader, Config &config) :
         GeneralProject(reader, config),
-        fail(false), t0(0), mesh_changed(false), first_run(true),
-		last_heat_time(-conf.behaviour.timestep_fs),
+        fail(false), t0(0), mesh_changed(false), mesh_morphed(false), first_run(true),
+		last_heat_time(-conf.behaviour.timestep_fs), heat_dt(conf.heating.delta_time),
 		last_restart_ts(0), restart_cntr(1),
+        n_coarse_points(0), cfactor(conf.cfactor), nodes_per_point(0), elems_per_point(0), time_per_node(0),
+        n_bulk_own(0), n_vacuum_own(0), mesh_cfactor(conf.cfactor),
 
         vacuum_interpolator(LABELS.elfield, LABELS.charge_density, LABELS.potential),
         bulk_interpolator(LABELS.rho, LABELS.potential, LABELS.temperature),
@@ -32,6 +42,7 @@ ProjectRunaway::ProjectRunaway(AtomReader &reader, Config &config) :
         surface_fields(&vacuum_interpolator),
         surface_temperatures(&bulk_interpolator),
         heat_transfer(&bulk_interpolator),
+        field_transfer(&vacuum_interpolator),
 
         phys_quantities(config.heating),
         poisson_solver(&config.field, &vacuum_interpolator.linhex),
@@ -42,6 +53,7 @@ ProjectRunaway::ProjectRunaway(AtomReader &reader, Config &config) :
     surface_fields.set_preferences(false, 2, 3);
     surface_temperatures.set_preferences(false, 2, 3);
     heat_transfer.set_preferences(true, 3, 1);
+    field_transfer.set_preferences(false, 3, 1);
 
     start_msg(t0, "Reading physical quantities");
     phys_quantities.initialize_with_hc_data();
@@ -71,9 +83,13 @@ int ProjectRunaway::finalize(double tstart) {
     GLOBALS.TIME = GLOBALS.TIMESTEP * conf.behaviour.timestep_fs;
 
     write_restart();
-    write_silent_msg("Total execution time " + d2s(omp_get_wtime()-tstart, 3));
+    const double run_time = omp_get_wtime() - tstart;
+    if (mesh_changed && mesh->nodes.size() > 0)
+        time_per_node = run_time / mesh->nodes.size();
+    write_silent_msg("Total execution time " + d2s(run_time, 3));
 
     mesh_changed = false;
+    mesh_morphed = false;
     first_run = false;
     return 0;
 }
@@ -98,7 +114,7 @@ int ProjectRunaway::run(const int timestep, const double time) {
         dense_surf.update_positions(reader);
     }
 
-    else if (generate_mesh())
+    else if (morph_mesh() && generate_mesh())
         return process_failed("Mesh generation failed!");
 
     if (prepare_solvers())
@@ -130,16 +146,26 @@ int ProjectRunaway::generate_boundary_nodes(Surface& bulk, Surface& coarse_surf,
     end_msg(t0);
     dense_surf.write("out/surface_dense.xyz");
 
-    if (first_run) {
+    if (first_run && extended_surf.size() == 0) {
         start_msg(t0, "Extending surface");
         dense_surf.extend(extended_surf, conf);
         end_msg(t0);
         extended_surf.write("out/surface_extension.xyz");
     }
 
+    // tuning always starts from the configured factors to avoid drifting away from them
+    cfactor = conf.cfactor;
+    const int n_target = get_coarse_budget();
+    if (n_target > 0) {
+        start_msg(t0, "Tuning coarseners");
+        cfactor = dense_surf.tune_coarseners(extended_surf, conf, n_target);
+        end_msg(t0);
+    }
+
     start_msg(t0, "Coarsening surface");
-    dense_surf.generate_boundary_nodes(bulk, coarse_surf, vacuum, extended_surf, conf, first_run);
+    dense_surf.generate_boundary_nodes(bulk, coarse_surf, vacuum, extended_surf, conf, cfactor, first_run);
     end_msg(t0);
+    n_coarse_points = coarse_surf.size();
 
     if (MODES.VERBOSE)
         printf("  #extended=%d, #coarse=%d, #dense=%d\n", extended_surf.size(), coarse_surf.size(), dense_surf.size());
@@ -151,17 +177,89 @@ int ProjectRunaway::generate_boundary_nodes(Surface& bulk, Surface& coarse_surf,
     return 0;
 }
 
+int ProjectRunaway::read_mesh_file() {
+    const string& mesh_file = conf.path.mesh_file;
+
+    // native copy of the mesh is kept among the cached meshes or in the output folder;
+    // the hash of the path distinguishes the meshes with the same file name
+    uint64_t hash = 14695981039346656037ULL;
+    for (const char c : mesh_file) {
+        hash ^= (unsigned char) c;
+        hash *= 1099511628211ULL;
+    }
+    const size_t name_start = mesh_file.find_last_of('/') + 1;
+    const string mesh_name = mesh_file.substr(name_start, mesh_file.find_last_of('.') - name_start);
+    stringstream ss;
+    ss << (conf.path.mesh_cache == "" ? "out" : conf.path.mesh_cache) << "/" << mesh_name << "_"
+            << hex << setw(16) << setfill('0') << hash << ".fmesh";
+    const string cache_file = ss.str();
+
+    // use the native copy of the mesh only if it is newer than the original one
+    const bool native = mesh_file.size() > 6 && mesh_file.substr(mesh_file.size() - 6) == ".fmesh";
+    struct stat mesh_info, cache_info;
+    const bool use_cache = !native
+            && stat(mesh_file.c_str(), &mesh_info) == 0
+            && stat(cache_file.c_str(), &cache_info) == 0
+            && cache_info.st_mtime >= mesh_info.st_mtime;
+
+    if (use_cache) {
+        // reading native mesh overwrites the time, which must stay intact here
+        const double time = GLOBALS.TIME;
+        const int timestep = GLOBALS.TIMESTEP;
+        start_msg(t0, "Reading mesh from " + cache_file);
+        const int err_code = new_mesh->read(cache_file, "");
+        GLOBALS.TIME = time;
+        GLOBALS.TIMESTEP = timestep;
+        if (!err_code) return 0;
+        end_msg(t0);
+        write_verbose_msg("Reading mesh cache failed, reading the original mesh instead");
+    }
+
+    start_msg(t0, "Reading mesh from file");
+    int err_code = new_mesh->read(mesh_file, native ? "" : "rQnn");
+    if (err_code || native) return err_code;
+
+    write_mesh_cache(cache_file);
+    return 0;
+}
+
+int ProjectRunaway::write_mesh_cache(const string& cache_file) const {
+    // temporary file must keep the extension, as it determines the file format
+    const size_t dot = cache_file.find_last_of('.');
+    const string tmp_file = cache_file.substr(0, dot) + "_" + d2s(getpid()) + ".tmp" + cache_file.substr(dot);
+
+    if (!ofstream(tmp_file)) {
+        write_verbose_msg("Can't write mesh cache " + cache_file);
+        return 1;
+    }
+
+    if (new_mesh->write(tmp_file, FileIO::force | FileIO::no_update)
+            || rename(tmp_file.c_str(), cache_file.c_str()))
+    {
+        remove(tmp_file.c_str());
+        write_verbose_msg("Can't write mesh cache " + cache_file);
+        return 1;
+    }
+    return 0;
+}
+
 int ProjectRunaway::generate_mesh() {
+    surf_node_ids.clear();
+    int n_bulk = n_bulk_own, n_vacuum = n_vacuum_own;
+
     if (conf.path.mesh_file != "") {
-        start_msg(t0, "Reading mesh from file");
-        fail = new_mesh->read(conf.path.mesh_file, "rQnn");
+        fail = read_mesh_file();
     } else {
-        Surface bulk, coarse_surf, vacuum;
-        fail = generate_boundary_nodes(bulk, coarse_surf, vacuum);
-        check_return(fail, "Generation of mesh generator nodes failed!");
+        fail = generate_new_mesh(n_bulk, n_vacuum);
 
-        start_msg(t0, "Generating vacuum & bulk mesh");
-        fail = new_mesh->generate(bulk, coarse_surf, vacuum, conf);
+        // first mesh has no predecessor, whose statistics would convert the budget
+        // into the number of coarse points, so it is used as a trial mesh instead
+        if (!fail && budget_missed()) {
+            end_msg(t0);
+            write_verbose_msg("First mesh missed the budget, generating it again");
+            surf_node_ids.clear();
+            fail = generate_new_mesh(n_bulk, n_vacuum);
+        }
     }
     end_msg(t0);
     if (fail) return 1;
@@ -182,33 +280,260 @@ int ProjectRunaway::generate_mesh() {
         mesh1.set_write_time(); mesh2.set_write_time();
     }
 
+    // store the statistics needed to meet the mesh budget
+    if (n_coarse_points > 0) {
+        nodes_per_point = new_mesh->nodes.size() / (double) n_coarse_points;
+        elems_per_point = new_mesh->hexs.size() / (double) n_coarse_points;
+    }
+
     // update mesh pointers
     mesh = new_mesh;
     mesh_changed = true;
+    n_bulk_own = n_bulk;
+    n_vacuum_own = n_vacuum;
+    mesh_cfactor = cfactor;
+    if (conf.path.mesh_file != "") mesh_roi.clear();
+    else mesh_roi = dense_surf.get_roi();
 
     write_verbose_msg(mesh->to_str());
+    write_verbose_msg("Mesh occupies " + d2s(mesh->memory_usage() / 1048576.0, 2) + " MB");
     return 0;
 }
 
-int ProjectRunaway::import_mesh() {
-    start_msg(t0, "Importing vacuum mesh to Deal.II");
-    fail = !poisson_solver.import_mesh(mesh->nodes.export_dealii(), mesh->hexs.export_vacuum());
-    check_return(fail, "Importing vacuum mesh to Deal.II failed!");
+int ProjectRunaway::generate_new_mesh(int& n_bulk, int& n_vacuum) {
+    Surface bulk, coarse_surf, vacuum;
+    check_return(generate_boundary_nodes(bulk, coarse_surf, vacuum), "Generation of mesh generator nodes failed!");
+
+    if (conf.geometry.morph_tol > 0) {
+        surf_node_ids.reserve(coarse_surf.size());
+        for (int i = 0; i < coarse_surf.size(); ++i)
+            surf_node_ids.push_back(coarse_surf.get_id(i));
+    }
+
+    n_bulk = bulk.size();
+    n_vacuum = vacuum.size();
+    if (!first_run && conf.geometry.remesh_buffer > 0)
+        reuse_mesh_nodes(bulk, coarse_surf, vacuum);
+
+    const string cache_file = get_mesh_cache_file(bulk, coarse_surf, vacuum);
+    struct stat cache_info;
+    if (cache_file != "" && stat(cache_file.c_str(), &cache_info) == 0) {
+        // reading native mesh overwrites the time, which must stay intact here
+        const double time = GLOBALS.TIME;
+        const int timestep = GLOBALS.TIMESTEP;
+        start_msg(t0, "Reading mesh from " + cache_file);
+        const int err_code = new_mesh->read(cache_file, "");
+        GLOBALS.TIME = time;
+        GLOBALS.TIMESTEP = timestep;
+        if (!err_code) return 0;
+        end_msg(t0);
+        write_verbose_msg("Reading mesh cache failed, generating the mesh instead");
+    }
+
+    start_msg(t0, "Generating vacuum & bulk mesh");
+    const int err_code = new_mesh->generate(bulk, coarse_surf, vacuum, conf);
+    if (!err_code && cache_file != "")
+        write_mesh_cache(cache_file);
+    return err_code;
+}
+
+bool ProjectRunaway::budget_missed() {
+    if (nodes_per_point > 0 || n_coarse_points <= 0) return false;
+    if (conf.cfactor.node_budget <= 0 && conf.cfactor.elem_budget <= 0) return false;
+
+    nodes_per_point = new_mesh->nodes.size() / (double) n_coarse_points;
+    elems_per_point = new_mesh->hexs.size() / (double) n_coarse_points;
+    const int n_target = get_coarse_budget();
+    return fabs(n_coarse_points - n_target) > conf.cfactor.budget_tol * n_target;
+}
+
+string ProjectRunaway::get_mesh_cache_file(const Surface& bulk, const Surface& coarse_surf,
+        const Surface& vacuum) const
+{
+    if (conf.path.mesh_cache == "") return "";
+
+    // FNV-1a hash of the generators and settings that affect mesh generation;
+    // coordinates are quantised to make the hash insensitive against round-off errors
+    uint64_t hash = 14695981039346656037ULL;
+    auto add_bytes = [&hash](const void* data, const size_t n_bytes) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < n_bytes; ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ULL;
+        }
+    };
+
+    const double quantum = 1e-3 * conf.geometry.latconst;
+    for (const Surface* medium : {&coarse_surf, &bulk, &vacuum}) {
+        const int n_atoms = medium->size();
+        add_bytes(&n_atoms, sizeof(int));
+        for (int i = 0; i < n_atoms; ++i) {
+            Point3 point = medium->get_point(i);
+            for (int j = 0; j < n_coordinates; ++j) {
+                const long long q = llround(point[j] / quantum);
+                add_bytes(&q, sizeof(long long));
+            }
+        }
+    }
+
+    const string settings = conf.geometry.mesh_quality + " " + conf.geometry.element_volume + " "
+            + conf.smoothing.algorithm + " " + d2s(conf.smoothing.n_steps) + " "
+            + d2s(conf.smoothing.lambda_mesh) + " " + d2s(conf.smoothing.mu_mesh);
+    add_bytes(settings.c_str(), settings.size());
+
+    stringstream ss;
+    ss << conf.path.mesh_cache << "/" << hex << setw(16) << setfill('0') << hash << ".fmesh";
+    return ss.str();
+}
+
+void ProjectRunaway::reuse_mesh_nodes(Surface& bulk, const Surface& coarse_surf, Surface& vacuum) {
+    // other coarsening changes the whole coarse surface, so the old nodes would not fit to it
+    const vector<Point3>& roi = dense_surf.get_roi();
+    bool same_coarsening = cfactor.amplitude == mesh_cfactor.amplitude
+            && cfactor.exponential == mesh_cfactor.exponential
+            && cfactor.r0_cylinder == mesh_cfactor.r0_cylinder
+            && cfactor.r0_sphere == mesh_cfactor.r0_sphere
+            && roi.size() == mesh_roi.size();
+    for (size_t i = 0; same_coarsening && i < roi.size(); ++i)
+        same_coarsening = roi[i].distance(mesh_roi[i]) <= conf.geometry.latconst;
+    if (!same_coarsening) {
+        write_verbose_msg("Coarsening has changed, no nodes are reused from previous mesh");
+        return;
+    }
+
+    Point3 box_min, box_max;
+    if (!reader.get_moved_region(box_min, box_max, conf.geometry.distance_tol))
+        return;
+
+    // The coarse surface may change also outside the region of moved atoms.
+    // The surface points that have no match in previous mesh within ~distance_tol are
+    // therefore also covered by the box, so that no old node ends up right next to them.
+    const double cell = max(conf.geometry.distance_tol, 1e-3 * conf.geometry.latconst);
+    auto get_key = [cell](const Point3& point) {
+        return array<long long,3>{(long long) floor(point.x / cell),
+            (long long) floor(point.y / cell), (long long) floor(point.z / cell)};
+    };
+
+    vector<array<long long,3>> old_keys;
+    for (int i = mesh->nodes.indxs.surf_start; i <= mesh->nodes.indxs.surf_end; ++i)
+        old_keys.push_back(get_key(mesh->nodes[i]));
+    sort(old_keys.begin(), old_keys.end());
+
+    for (int i = 0; i < coarse_surf.size(); ++i) {
+        const Point3 point = coarse_surf.get_point(i);
+        const array<long long,3> key = get_key(point);
+        bool found = false;
+        for (int dx = -1; dx <= 1 && !found; ++dx)
+            for (int dy = -1; dy <= 1 && !found; ++dy)
+                for (int dz = -1; dz <= 1 && !found; ++dz)
+                    found = binary_search(old_keys.begin(), old_keys.end(),
+                            array<long long,3>{key[0] + dx, key[1] + dy, key[2] + dz});
+        if (found) continue;
+
+        for (int j = 0; j < n_coordinates; ++j) {
+            box_min[j] = min(box_min[j], point[j]);
+            box_max[j] = max(box_max[j], point[j]);
+        }
+    }
+
+    const double buffer = conf.geometry.remesh_buffer * conf.geometry.latconst;
+    box_min -= buffer;
+    box_max += buffer;
+
+    const int n_generators = bulk.size() + vacuum.size();
+    mesh->get_tetgen_nodes(bulk, vacuum, box_min, box_max, n_bulk_own, n_vacuum_own);
+    write_verbose_msg("Reused " + d2s(bulk.size() + vacuum.size() - n_generators)
+            + " nodes from previous mesh");
+}
+
+int ProjectRunaway::get_coarse_budget() const {
+    if (nodes_per_point <= 0 || elems_per_point <= 0) return 0;
+
+    double n_target = DBL_MAX;
+    if (conf.cfactor.node_budget > 0)
+        n_target = min(n_target, conf.cfactor.node_budget / nodes_per_point);
+    if (conf.cfactor.elem_budget > 0)
+        n_target = min(n_target, conf.cfactor.elem_budget / elems_per_point);
+    if (conf.cfactor.time_budget > 0 && time_per_node > 0)
+        n_target = min(n_target, conf.cfactor.time_budget / (time_per_node * nodes_per_point));
+
+    if (n_target == DBL_MAX) return 0;
+    return max(1, (int) n_target);
+}
+
+int ProjectRunaway::morph_mesh() {
+    if (first_run || reader.get_rmsd() >= conf.geometry.morph_tol)
+        return 1;
+
+    const int n_surf = surf_node_ids.size();
+    if (n_surf == 0 || n_surf != mesh->nodes.indxs.surf_end - mesh->nodes.indxs.surf_start + 1)
+        return 1;
+
+    // surface nodes that correspond to atoms follow them, the rest stay in place
+    start_msg(t0, "Morphing mesh");
+    vector<Vec3> displacements(n_surf, Vec3(0));
+    for (int i = 0; i < n_surf; ++i)
+        if (surf_node_ids[i] >= 0 && surf_node_ids[i] < reader.size())
+            displacements[i] = reader.get_displacement(surf_node_ids[i]);
+
+    fail = mesh->morph(displacements);
     end_msg(t0);
+    check_return(fail, "Morphing mesh inverted some of the elements; generating new mesh.");
+
+    dense_surf.update_positions(reader);
+    mesh_changed = true;
+    mesh_morphed = true;
 
-    if (conf.field.mode != "laplace" || conf.heating.mode != "none") {
-        start_msg(t0, "Importing bulk mesh to Deal.II");
-        fail = !ch_solver.import_mesh(mesh->nodes.export_dealii(), mesh->hexs.export_bulk());
-        check_return(fail, "Importing bulk mesh to Deal.II failed!");
+    write_verbose_msg(mesh->to_str());
+    return 0;
+}
+
+int ProjectRunaway::import_mesh() {
+    if (mesh_morphed) {
+        start_msg(t0, "Moving Deal.II mesh vertices");
+        fail = !poisson_solver.update_vertices(mesh->nodes.export_dealii(), mesh->hexs.export_vacuum());
+        if (!fail && (conf.field.mode != "laplace" || conf.heating.mode != "none"))
+            fail = !ch_solver.update_vertices(mesh->nodes.export_dealii(), mesh->hexs.export_bulk());
+        check_return(fail, "Moving Deal.II mesh vertices failed!");
         end_msg(t0);
+        return 0;
     }
 
+    const bool import_bulk = conf.field.mode != "laplace" || conf.heating.mode != "none";
+    bool vacuum_fail = false, bulk_fail = false;
+
+    if (import_bulk) start_msg(t0, "Importing vacuum & bulk meshes to Deal.II");
+    else start_msg(t0, "Importing vacuum mesh to Deal.II");
+
+    // the meshes are independent, therefore they can be imported concurrently
+#pragma omp parallel sections num_threads(2)
+    {
+#pragma omp section
+        {
+            vector<dealii::Point<3>> vertices;
+            vector<dealii::CellData<3>> cells;
+            mesh->export_dealii(vertices, cells, TYPES.VACUUM);
+            vacuum_fail = !poisson_solver.import_compact_mesh(vertices, cells);
+        }
+#pragma omp section
+        if (import_bulk) {
+            vector<dealii::Point<3>> vertices;
+            vector<dealii::CellData<3>> cells;
+            mesh->export_dealii(vertices, cells, TYPES.BULK);
+            bulk_fail = !ch_solver.import_compact_mesh(vertices, cells);
+        }
+    }
+
+    check_return(vacuum_fail, "Importing vacuum mesh to Deal.II failed!");
+    check_return(bulk_fail, "Importing bulk mesh to Deal.II failed!");
+    end_msg(t0);
+
     return 0;
 }
 
 void ProjectRunaway::update_mesh_pointers() {
     static bool odd_run = true;
-    if (mesh_changed) {
+    if (mesh_changed && !mesh_morphed) {
         if (odd_run) new_mesh = &mesh2;
         else new_mesh = &mesh1;
         odd_run = !odd_run;
@@ -241,10 +566,13 @@ int ProjectRunaway::prepare_solvers() {
     // initialize the calculation of field emission
     if (mesh_changed) {
         // setup ch_solver here as it must be done before transferring previous heat values into new mesh,
-        // which in turn must be done before re-initializing bulk_interpolator
-        start_msg(t0, "Setup current & heat solvers");
-        ch_solver.setup(conf.heating.t_ambient);
-        end_msg(t0);
+        // which in turn must be done before re-initializing bulk_interpolator;
+        // morphed mesh keeps its dofs, therefore its temperatures need no transfer
+        if (!mesh_morphed) {
+            start_msg(t0, "Setup current & heat solvers");
+            ch_solver.setup(conf.heating.t_ambient);
+            end_msg(t0);
+        }
         write_verbose_msg(ch_solver.heat.to_str());
 
         ch_solver.export_surface_centroids(surface_fields);
@@ -254,7 +582,7 @@ int ProjectRunaway::prepare_solvers() {
         // otherwise transfer existing temperatures to new mesh
         if (bulk_interpolator.nodes.size() == 0) {
             bulk_interpolator.initialize(mesh, conf.heating.t_ambient, TYPES.BULK);
-        } else {
+        } else if (!mesh_morphed) {
             start_msg(t0, "Transferring old temperatures to new mesh");
             heat_transfer.interpolate_dofs(ch_solver, mesh);
             end_msg(t0);
@@ -337,8 +665,10 @@ int ProjectRunaway::run_heat_solver() {
     int ccg, hcg;
 
     double delta_time = GLOBALS.TIME - last_heat_time;
+    // adaptive time stepping only divides the update interval into sub-steps
     bool b1 = delta_time >= conf.heating.delta_time;
-    if (conf.heating.mode == "transient" && (mesh_changed || b1))
+    bool b2 = conf.heating.mode == "transient" || conf.heating.mode == "stationary";
+    if (b2 && (mesh_changed || b1))
         return solve_heat(conf.heating.t_ambient, delta_time, mesh_changed, ccg, hcg);
 
     return 0;
@@ -392,7 +722,19 @@ int ProjectRunaway::solve_force() {
 
 int ProjectRunaway::solve_laplace(double E0, double V0) {
     start_msg(t0, "Initializing Laplace solver");
-    poisson_solver.setup(-E0, V0);
+    poisson_solver.setup(-E0, V0, !mesh_morphed);
+    end_msg(t0);
+
+    // morphed mesh keeps its dofs together with the previous solution,
+    // otherwise start the solver from the previous solution transferred to new mesh;
+    // it must be done before the assembly, as Dirichlet BCs are also applied to the solution vector
+    if (!mesh_morphed && vacuum_interpolator.nodes.size() > 0) {
+        start_msg(t0, "Transferring old potentials to new mesh");
+        field_transfer.interpolate_dofs(poisson_solver);
+        end_msg(t0);
+    }
+
+    start_msg(t0, "Assembling Laplace equation");
     poisson_solver.assemble(true);
     end_msg(t0);
 
@@ -418,19 +760,20 @@ int ProjectRunaway::solve_laplace(double E0, double V0) {
 }
 
 int ProjectRunaway::solve_heat(double T_ambient, double delta_time, bool full_run, int& ccg, int& hcg) {
-    calc_heat_emission(full_run);
+    if (conf.heating.mode == "stationary")
+        return solve_stationary_heat(full_run, ccg, hcg);
 
-    start_msg(t0, "Calculating current density");
-    ch_solver.current.assemble();
-    ccg = ch_solver.current.solve();
-    end_msg(t0);
-    check_return(ccg < 0, "Current solver did not complete normally,"
-            " #CG=" + d2s(abs(ccg)) + "/" + d2s(conf.heating.n_cg));
-    write_verbose_msg("#CG steps: " + d2s(ccg));
+    if (solve_current(full_run, ccg)) return 1;
 
     start_msg(t0, "Calculating temperature distribution");
-    ch_solver.heat.assemble(delta_time * 1.e-15); // caution!! ch_solver internal time in sec
-    hcg = ch_solver.heat.solve();
+    if (conf.heating.dt_tolerance > 0) {
+        double dt = heat_dt * 1.e-15; // caution!! ch_solver internal time in sec
+        hcg = ch_solver.heat.solve_adaptive(delta_time * 1.e-15, conf.heating.dt_max * 1.e-15, dt);
+        heat_dt = dt * 1.e15;
+    } else {
+        ch_solver.heat.assemble(delta_time * 1.e-15); // caution!! ch_solver internal time in sec
+        hcg = ch_solver.heat.solve();
+    }
     end_msg(t0);
     check_return(hcg < 0, "Heat solver did not complete normally,"
             " #CG=" + d2s(abs(hcg)) + "/" + d2s(conf.heating.n_cg));
@@ -438,6 +781,61 @@ int ProjectRunaway::solve_heat(double T_ambient, double delta_time, bool full_ru
     ch_solver.write("out/ch_solver.movie");
     write_verbose_msg("#CG steps: " + d2s(hcg));
 
+    extract_heat();
+    last_heat_time = GLOBALS.TIME;
+    // TODO implement reasonable temperature limit check
+    return 0;
+}
+
+int ProjectRunaway::solve_stationary_heat(bool full_run, int& ccg, int& hcg) {
+    ccg = hcg = 0;
+    double t_change = DBL_MAX;
+
+    // Emission depends on surface temperatures and provides the BCs for current and heat,
+    // so they are all updated before every Newton step to reach the coupled steady state
+    for (int i = 0; i < conf.heating.n_newton && t_change >= conf.heating.t_error; ++i) {
+        if (i > 0) {
+            start_msg(t0, "Calculating surface temperatures");
+            surface_temperatures.calc_interpolation();
+            end_msg(t0);
+        }
+
+        int n_steps;
+        if (solve_current(full_run && i == 0, n_steps)) return 1;
+        ccg += n_steps;
+
+        start_msg(t0, "Making Newton step for temperatures");
+        n_steps = ch_solver.heat.solve_newton(t_change);
+        end_msg(t0);
+        check_return(n_steps < 0, "Heat solver did not complete normally,"
+                " #GMRES=" + d2s(abs(n_steps)) + "/" + d2s(conf.heating.n_cg));
+        hcg += n_steps;
+        write_verbose_msg("#GMRES steps: " + d2s(n_steps) + ", max dT=" + d2s(t_change) + " K");
+
+        extract_heat();
+    }
+
+    ch_solver.write("out/ch_solver.movie");
+    last_heat_time = GLOBALS.TIME;
+    check_return(t_change >= conf.heating.t_error, "Stationary temperatures did not converge in "
+            + d2s(conf.heating.n_newton) + " Newton steps, max dT=" + d2s(t_change) + " K");
+    return 0;
+}
+
+int ProjectRunaway::solve_current(bool full_run, int& ccg) {
+    calc_heat_emission(full_run);
+
+    start_msg(t0, "Calculating current density");
+    ch_solver.current.assemble();
+    ccg = ch_solver.current.solve();
+    end_msg(t0);
+    check_return(ccg < 0, "Current solver did not complete normally,"
+            " #CG=" + d2s(abs(ccg)) + "/" + d2s(conf.heating.n_cg));
+    write_verbose_msg("#CG steps: " + d2s(ccg));
+    return 0;
+}
+
+void ProjectRunaway::extract_heat() {
     start_msg(t0, "Extracting J & T");
     bulk_interpolator.initialize(mesh, conf.heating.t_ambient, TYPES.BULK);
     bulk_interpolator.extract_solution(ch_solver);
@@ -445,10 +843,6 @@ int ProjectRunaway::solve_heat(double T_ambient, double delta_time, bool full_ru
 
     bulk_interpolator.nodes.write("out/result_J_T.xyz");
     bulk_interpolator.lintet.write("out/result_J_T.vtk");
-
-    last_heat_time = GLOBALS.TIME;
-    // TODO implement reasonable temperature limit check
-    return 0;
 }
 
 void ProjectRunaway::calc_heat_emission(bool full_run) {
@@ -363,6 +363,19 @@ void FieldReader::calc_interpolation() {
     }
 }
 
+void FieldReader::interpolate_dofs(PoissonSolver<3>& solver) {
+    solver.export_vertices(*this);
+    // field norms are not needed, therefore no need to call FieldReader::calc_interpolation
+    SolutionReader::calc_interpolation();
+
+    const int n_points = size();
+    vector<double> potentials(n_points);
+    for (int i = 0; i < n_points; ++i)
+        potentials[i] = interpolation[i].scalar;
+
+    solver.import_solution(&potentials);
+}
+
 double FieldReader::get_analyt_potential(const int i, const Point3& origin) const {
     require(i >= 0 && i < size(), "Invalid index: " + to_string(i));
 
@@ -526,10 +539,14 @@ void HeatReader::interpolate_dofs(CurrentHeatSolver<3>& solver, const TetgenMesh
     // transfer temperatures and potentials into separate vectors
     const int n_points = size();
     temperatures.resize(n_points);
-    for (int i = 0; i < n_points; ++i)
+    potentials.resize(n_points);
+    for (int i = 0; i < n_points; ++i) {
         temperatures[i] = interpolation[i].scalar;
+        potentials[i] = interpolation[i].norm;
+    }
 
     solver.heat.import_solution(&temperatures);
+    solver.current.import_solution(&potentials);
 }
 
 void HeatReader::precalc_berendsen() {
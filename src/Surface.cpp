@@ -149,13 +149,20 @@ void Surface::clean(Surface& surface) {
     surface.calc_statistics();
 }
 
-void Surface::add_cleaned_roi_to(Surface& surface) {
+void Surface::mark_roi(vector<bool>& in_roi) const {
+    const int n_atoms = size();
+    in_roi.resize(n_atoms);
+    for (int i = 0; i < n_atoms; ++i)
+        in_roi[i] = coarseners.inside_interesting_region(get_point(i));
+}
+
+void Surface::add_cleaned_roi_to(Surface& surface, const vector<bool>& in_roi) {
     const int n_atoms = size();
     vector<int> do_delete(n_atoms, 0);
 
     // mark atoms outside the nanotip
     for (int i = 0; i < n_atoms; ++i)
-        do_delete[i] = -1 * !coarseners.inside_interesting_region(get_point(i));
+        do_delete[i] = -1 * !in_roi[i];
 
     // Loop through all the nanotip atoms
     for (int i = 0; i < n_atoms; ++i) {
@@ -351,7 +358,7 @@ void Surface::smoothen(const double smooth_factor, const double r_cut) {
 }
 
 void Surface::extend(Surface& extended_surf, const Config& conf) {
-    coarseners.generate(*this, conf.geometry.radius, conf.cfactor, conf.geometry.latconst);
+    coarseners.generate(*this, conf.geometry.radius, conf.cfactor, conf.geometry.latconst, conf.geometry.n_roi);
 
     if (conf.path.extended_atoms == "") {
         // Extend surface by generating additional nodes
@@ -376,19 +383,101 @@ void Surface::extend(Surface& extended_surf, const Config& conf) {
     }
 }
 
+int Surface::count_coarse_points(const Surface& extended_surf, const vector<bool>& in_roi,
+        const Config& conf, const Config::CoarseFactor& cf)
+{
+    coarseners.set_factors(cf, conf.geometry.latconst);
+
+    Surface coarse_surf;
+    coarse_surf.atoms = extended_surf.atoms;
+    add_cleaned_roi_to(coarse_surf, in_roi);
+    clean(coarse_surf);
+    return coarse_surf.size();
+}
+
+Config::CoarseFactor Surface::tune_coarseners(const Surface& extended_surf, const Config& conf,
+        const int n_target)
+{
+    const int max_trials = 6;        // max number of trial coarsenings in total
+    const double amplitude_span = 100.0;
+    const double exponent_min = 0.1, exponent_max = 1.0;
+
+    Config::CoarseFactor cf = conf.cfactor;
+    if (cf.amplitude <= 0) cf.amplitude = 0.4;
+
+    // the atoms and the regions of interest don't depend on the coarsening factors,
+    // so they are prepared once and reused in all the trials
+    sort_atoms(3, "down");
+    coarseners.generate(*this, conf.geometry.radius, cf, conf.geometry.latconst, conf.geometry.n_roi);
+    vector<bool> in_roi;
+    mark_roi(in_roi);
+
+    int n_trials = 1;
+    int n_points = count_coarse_points(extended_surf, in_roi, conf, cf);
+    auto on_target = [&n_points, n_target, &conf]() {
+        return fabs(n_points - n_target) <= conf.cfactor.budget_tol * n_target;
+    };
+
+    // Search the amplitude on logarithmic scale; bigger amplitude gives less points.
+    // As #points depends on amplitude approximately as a power law,
+    // secant step in log-log scale is used whenever it stays inside the bisection bracket.
+    double a_min = cf.amplitude / amplitude_span;
+    double a_max = cf.amplitude * amplitude_span;
+    double prev_amplitude = 0;
+    int prev_n_points = 0;
+    while (n_trials < max_trials && !on_target()) {
+        if (n_points > n_target) a_min = cf.amplitude;
+        else a_max = cf.amplitude;
+
+        double amplitude = sqrt(a_min * a_max);
+        if (prev_n_points > 0 && n_points > 0 && prev_n_points != n_points) {
+            const double slope = log((double) n_points / prev_n_points) / log(cf.amplitude / prev_amplitude);
+            const double secant = cf.amplitude * pow((double) n_target / n_points, 1.0 / slope);
+            if (secant > a_min && secant < a_max)
+                amplitude = secant;
+        }
+
+        prev_amplitude = cf.amplitude;
+        prev_n_points = n_points;
+        cf.amplitude = amplitude;
+        n_points = count_coarse_points(extended_surf, in_roi, conf, cf);
+        n_trials++;
+    }
+
+    // Bisect the exponent with the remaining trials if amplitude alone was not sufficient;
+    // bigger exponent gives less points
+    double e_min = min(exponent_min, cf.exponential);
+    double e_max = max(exponent_max, cf.exponential);
+    while (n_trials < max_trials && !on_target()) {
+        if (n_points > n_target) e_min = cf.exponential;
+        else e_max = cf.exponential;
+        cf.exponential = 0.5 * (e_min + e_max);
+        n_points = count_coarse_points(extended_surf, in_roi, conf, cf);
+        n_trials++;
+    }
+
+    write_silent_msg("Tuned coarsening factors: amplitude=" + d2s(cf.amplitude)
+            + ", exponent=" + d2s(cf.exponential) + ", #points=" + d2s(n_points)
+            + ", target=" + d2s(n_target));
+    return cf;
+}
+
 int Surface::generate_boundary_nodes(Surface& bulk, Surface& coarse_surf, Surface& vacuum,
-        const Surface& extended_surf, const Config& conf, const bool first_time)
+        const Surface& extended_surf, const Config& conf, const Config::CoarseFactor& cf,
+        const bool first_time)
 {
     if (!first_time)
-        coarseners.generate(*this, conf.geometry.radius, conf.cfactor, conf.geometry.latconst);
+        coarseners.generate(*this, conf.geometry.radius, cf, conf.geometry.latconst, conf.geometry.n_roi);
 
     // sort atoms radially to increase the symmetry or the resulting surface
     sort_atoms(3, "down");
 
     // Coarsen & smoothen surface
+    vector<bool> in_roi;
+    mark_roi(in_roi);
     coarse_surf.atoms = extended_surf.atoms;
 //    coarse_surf += *this;
-    add_cleaned_roi_to(coarse_surf);
+    add_cleaned_roi_to(coarse_surf, in_roi);
     clean(coarse_surf);
     coarse_surf.smoothen(conf.geometry.radius, conf.smoothing.beta_atoms, 3.0*conf.geometry.coordination_cutoff);
 
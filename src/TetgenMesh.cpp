@@ -8,6 +8,18 @@
 #include "TetgenMesh.h"
 #include "Tethex.h"
 #include <fstream>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <float.h>
+#include <limits.h>
+#include <numeric>
+#include <tuple>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace std;
 namespace femocs {
@@ -24,99 +36,104 @@ void TetgenMesh::smoothen(const int n_steps, const double lambda, const double m
     if (algorithm == "none") return;
 
     // determine the neighbouring between nodes connected to the faces
-    vector<vector<unsigned>> nborlist;
-    tris.calc_nborlist(nborlist);
+    vector<int> offsets, nbors;
+    tris.calc_nborlist(offsets, nbors);
 
-    // remove the nodes that are on the boundary of simubox
+    // pick the surface nodes that are not on the boundary of simubox
     const double eps = 0.01 * tets.stat.edgemin;
     nodes.calc_statistics();
+    vector<int> surf_nodes;
     for (int i = 0; i < nodes.size(); ++i) {
         Point3 p = nodes[i];
-        if (on_boundary(p.x, nodes.stat.xmin, nodes.stat.xmax, eps) ||
+        if (offsets[i+1] > offsets[i] && !(on_boundary(p.x, nodes.stat.xmin, nodes.stat.xmax, eps) ||
                 on_boundary(p.y, nodes.stat.ymin, nodes.stat.ymax, eps) ||
-                on_boundary(p.z, nodes.stat.zmin, nodes.stat.zmax, eps))
-            nborlist[i] = vector<unsigned>();
+                on_boundary(p.z, nodes.stat.zmin, nodes.stat.zmax, eps)))
+            surf_nodes.push_back(i);
     }
 
+    vector<double> weights(nbors.size());
+    vector<Point3> displacements(surf_nodes.size());
+
     // run the Taubin smoothing
     if (algorithm == "laplace") {
+        calc_laplace_weights(weights, surf_nodes, offsets);
         for (int s = 0; s < n_steps; ++s) {
-            laplace_smooth(lambda, nborlist);
-            laplace_smooth(mu, nborlist);
+            smooth_step(lambda, surf_nodes, offsets, nbors, weights, displacements);
+            smooth_step(mu, surf_nodes, offsets, nbors, weights, displacements);
         }
     }
 
+    // the weights are updated once per lambda|mu step pair
     else if (algorithm == "fujiwara") {
         for (int s = 0; s < n_steps; ++s) {
-            fujiwara_smooth(lambda, nborlist);
-            fujiwara_smooth(mu, nborlist);
+            calc_fujiwara_weights(weights, surf_nodes, offsets, nbors);
+            smooth_step(lambda, surf_nodes, offsets, nbors, weights, displacements);
+            smooth_step(mu, surf_nodes, offsets, nbors, weights, displacements);
         }
     }
 }
 
-void TetgenMesh::laplace_smooth(const double scale, const vector<vector<unsigned>>& nborlist) {
-    size_t n_nodes = nodes.size();
-    vector<Point3> displacements(n_nodes);
-
-    // Get per-vertex displacement
-    for(size_t i = 0; i < n_nodes; ++i) {
-        // Skip vertices that are not on the surface
-        if (nborlist[i].size() == 0)
-            continue;
-
-        const double weight = 1.0 / nborlist[i].size();
-
-        // Sum the displacements
-        for(size_t nbor : nborlist[i])
-            displacements[i] += (nodes[nbor] - nodes[i]) * weight;
+void TetgenMesh::calc_laplace_weights(vector<double>& weights, const vector<int>& surf_nodes,
+        const vector<int>& offsets) const
+{
+    const int n_surf_nodes = surf_nodes.size();
+
+#pragma omp parallel for
+    for (int i = 0; i < n_surf_nodes; ++i) {
+        const int node = surf_nodes[i];
+        const double weight = 1.0 / (offsets[node+1] - offsets[node]);
+        for (int j = offsets[node]; j < offsets[node+1]; ++j)
+            weights[j] = weight;
     }
-
-    // Apply per-vertex displacement
-    for (size_t i = 0; i < n_nodes; ++i)
-        nodes.set_node(i, nodes[i] + displacements[i]*scale);
 }
 
-void TetgenMesh::fujiwara_smooth(const double scale, const vector<vector<unsigned>>& nborlist) {
-    vector<Point3> displacements(nodes.size());
-    const unsigned int n_nodes = nodes.size();
+void TetgenMesh::calc_fujiwara_weights(vector<double>& weights, const vector<int>& surf_nodes,
+        const vector<int>& offsets, const vector<int>& nbors) const
+{
+    const int n_surf_nodes = surf_nodes.size();
 
-    // Get per-vertex displacement.
-    for (size_t i = 0; i < n_nodes; ++i) {
-        // Skip vertices that are not on the surface.
-        if (nborlist[i].size() == 0)
-            continue;
-
-        vector<double> weights(nborlist[i].size());
-        Point3 node = nodes[i];
+#pragma omp parallel for
+    for (int i = 0; i < n_surf_nodes; ++i) {
+        const int node = surf_nodes[i];
+        Point3 point = nodes[node];
 
         // Calculate Fujiwara weights based on edge lengths.
-        for (size_t j = 0; j < nborlist[i].size(); j++) {
-            size_t nbor = nborlist[i][j];
-
-            double edge_length = node.distance(nodes[nbor]);
+        double sum = 0;
+        for (int j = offsets[node]; j < offsets[node+1]; ++j) {
+            double edge_length = point.distance(nodes[nbors[j]]);
             expect(edge_length > 0, "Zero edge not allowed!");
-
             weights[j] = 1.0 / edge_length;
+            sum += weights[j];
         }
 
         // Normalize the weights so that they sum up to 1.
-        double s = vector_sum(weights);
-        if (s == 0) s = numeric_limits<float>::epsilon();
+        if (sum == 0) sum = numeric_limits<float>::epsilon();
+        sum = 1.0 / sum;
+        for (int j = offsets[node]; j < offsets[node+1]; ++j)
+            weights[j] *= sum;
+    }
+}
 
-        s = 1.0 / s;
-        for (size_t j = 0; j < weights.size(); j++)
-            weights[j] *= s;
+void TetgenMesh::smooth_step(const double scale, const vector<int>& surf_nodes, const vector<int>& offsets,
+        const vector<int>& nbors, const vector<double>& weights, vector<Point3>& displacements)
+{
+    const int n_surf_nodes = surf_nodes.size();
 
-        // Sum the displacements.
-        for(size_t j = 0; j < nborlist[i].size(); j++) {
-            size_t nbor = nborlist[i][j];
-            displacements[i] += (nodes[nbor] - node) * weights[j];
-        }
+    // Get per-vertex displacement
+#pragma omp parallel for
+    for (int i = 0; i < n_surf_nodes; ++i) {
+        const int node = surf_nodes[i];
+        Point3 point = nodes[node];
+        Point3 displacement(0);
+        for (int j = offsets[node]; j < offsets[node+1]; ++j)
+            displacement += (nodes[nbors[j]] - point) * weights[j];
+        displacements[i] = displacement * scale;
     }
 
-    // Apply per-vertex displacement.
-    for (size_t i = 0; i < n_nodes; i++)
-        nodes.set_node(i, nodes[i] + displacements[i]*scale);
+    // Apply per-vertex displacement
+#pragma omp parallel for
+    for (int i = 0; i < n_surf_nodes; ++i)
+        nodes.set_node(surf_nodes[i], nodes[surf_nodes[i]] + displacements[i]);
 }
 
 int TetgenMesh::generate_simple() {
@@ -149,7 +166,191 @@ int TetgenMesh::generate_simple() {
     return recalc("rQ");
 }
 
-int TetgenMesh::generate_union(const Medium& bulk, const Medium& surf, const Medium& vacuum, const string& cmd) {
+void TetgenMesh::get_tetgen_nodes(Medium& bulk, Medium& vacuum,
+        const Point3& box_min, const Point3& box_max, const int n_bulk_own, const int n_vacuum_own) const
+{
+    const int node_min = nodes.indxs.bulk_start;
+    const int node_max = nodes.indxs.tetnode_end;
+    if (node_max < node_min) return;
+
+    vector<int> domain(node_max - node_min + 1, TYPES.NONE);
+
+    // nodes reused by previous remeshing are in the end of generator ranges
+    for (int node = nodes.indxs.bulk_start + n_bulk_own; node <= nodes.indxs.bulk_end; ++node)
+        domain[node - node_min] = TYPES.BULK;
+    for (int node = nodes.indxs.vacuum_start + n_vacuum_own; node <= nodes.indxs.vacuum_end; ++node)
+        domain[node - node_min] = TYPES.VACUUM;
+
+    // the sign of hexahedron marker shows the domain of its tetrahedral node
+    for (int i = 0; i < hexs.size(); ++i) {
+        const int marker = hexs.get_marker(i);
+        const int node = abs(marker) - 1;
+        if (node >= nodes.indxs.tetgen_start && node <= node_max)
+            domain[node - node_min] = marker > 0 ? TYPES.VACUUM : TYPES.BULK;
+    }
+
+    // mark the nodes inside the box as not reusable
+    int n_vacuum = 0, n_bulk = 0;
+    for (int node = node_min; node <= node_max; ++node) {
+        int &type = domain[node - node_min];
+        if (type == TYPES.NONE) continue;
+
+        Point3 point = nodes[node];
+        bool in_box = true;
+        for (int j = 0; j < n_coordinates; ++j)
+            in_box &= point[j] >= box_min[j] && point[j] <= box_max[j];
+
+        if (in_box) type = TYPES.NONE;
+        else if (type == TYPES.VACUUM) n_vacuum++;
+        else n_bulk++;
+    }
+
+    // the nodes are appended in the order of their coordinates instead of their indices,
+    // so that their order doesn't depend on how many times they have been already reused
+    vector<int> reused;
+    reused.reserve(n_vacuum + n_bulk);
+    for (int node = node_min; node <= node_max; ++node)
+        if (domain[node - node_min] != TYPES.NONE)
+            reused.push_back(node);
+    sort(reused.begin(), reused.end(), [this](const int n1, const int n2) {
+        const Point3 p1 = nodes[n1], p2 = nodes[n2];
+        return tie(p1.x, p1.y, p1.z) < tie(p2.x, p2.y, p2.z);
+    });
+
+    vacuum.resize(vacuum.size() + n_vacuum);
+    bulk.resize(bulk.size() + n_bulk);
+    for (int node : reused) {
+        if (domain[node - node_min] == TYPES.VACUUM)
+            vacuum.append(nodes[node]);
+        else
+            bulk.append(nodes[node]);
+    }
+}
+
+int TetgenMesh::morph(const vector<Vec3>& displacements) {
+    const int max_steps = 1000;  // max number of relaxation sweeps
+    const int n_surf = nodes.indxs.surf_end - nodes.indxs.surf_start + 1;
+    const int n_tetnodes = nodes.indxs.tetnode_end + 1;
+    const int n_nodes = nodes.size();
+    const double eps = 0.01 * tets.stat.edgemin;
+
+    require(n_surf == (int)displacements.size(), "Mismatch between #surface nodes and #displacements: "
+            + d2s(n_surf) + " vs " + d2s(displacements.size()));
+    require(n_tetnodes > n_surf && n_tetnodes <= n_nodes, "Invalid number of tetrahedral nodes: " + d2s(n_tetnodes));
+
+    vector<int> orientations;
+    calc_hex_orientations(orientations);
+
+    // surface nodes move together with the atoms
+    // while the nodes on simulation cell perimeter stay in place
+    vector<Vec3> disp(n_tetnodes, Vec3(0));
+    vector<bool> fixed(n_tetnodes, false);
+    double max_disp = 0;
+    for (int i = 0; i < n_surf; ++i) {
+        disp[nodes.indxs.surf_start + i] = displacements[i];
+        fixed[nodes.indxs.surf_start + i] = true;
+        max_disp = max(max_disp, displacements[i].norm());
+    }
+    for (int i = 0; i < n_tetnodes; ++i) {
+        Point3 point = nodes[i];
+        fixed[i] = fixed[i] || on_boundary(point.x, nodes.stat.xmin, nodes.stat.xmax, eps)
+                || on_boundary(point.y, nodes.stat.ymin, nodes.stat.ymax, eps)
+                || on_boundary(point.z, nodes.stat.zmin, nodes.stat.zmax, eps);
+    }
+
+    // relax the displacements of remaining tetrahedral nodes with Jacobi sweeps,
+    // that are independent between the nodes, until the displacements stop changing
+    const double tol = 1e-4 * max_disp;
+    vector<int> offsets, nbors;
+    tets.calc_nborlist(offsets, nbors);
+    vector<Vec3> new_disp(disp);
+    for (int step = 0; step < max_steps; ++step) {
+        double max_change = 0;
+#pragma omp parallel for reduction(max:max_change)
+        for (int i = 0; i < n_tetnodes; ++i) {
+            const int n_nbors = offsets[i+1] - offsets[i];
+            if (fixed[i] || n_nbors == 0) continue;
+            Vec3 sum(0);
+            for (int j = offsets[i]; j < offsets[i+1]; ++j)
+                sum += disp[nbors[j]];
+            new_disp[i] = sum / n_nbors;
+            Vec3 change = new_disp[i] - disp[i];
+            max_change = max(max_change, change.norm());
+        }
+        disp.swap(new_disp);
+        if (max_change <= tol) break;
+    }
+
+    // the nodes on the edges, faces and centroids of tetrahedra follow the tetrahedral nodes,
+    // as the hexahedron marker shows the index of its tetrahedral node
+    vector<Vec3> hex_disp(n_nodes - n_tetnodes, Vec3(0));
+    vector<int> n_hex_disp(n_nodes - n_tetnodes, 0);
+    for (int i = 0; i < hexs.size(); ++i) {
+        const int tetnode = abs(hexs.get_marker(i)) - 1;
+        require(tetnode >= 0 && tetnode < n_tetnodes, "Invalid hexahedron marker: " + d2s(hexs.get_marker(i)));
+        for (int node : hexs[i])
+            if (node >= n_tetnodes) {
+                hex_disp[node - n_tetnodes] += disp[tetnode];
+                n_hex_disp[node - n_tetnodes]++;
+            }
+    }
+
+    // move the nodes and store the old positions in case of failure
+    vector<Point3> old_nodes; old_nodes.reserve(n_nodes);
+    for (int i = 0; i < n_nodes; ++i) {
+        old_nodes.push_back(nodes[i]);
+        if (i < n_tetnodes)
+            nodes.set_node(i, old_nodes[i] + disp[i]);
+        else if (n_hex_disp[i - n_tetnodes] > 0)
+            nodes.set_node(i, old_nodes[i] + hex_disp[i - n_tetnodes] / n_hex_disp[i - n_tetnodes]);
+    }
+
+    // check that none of the hexahedra got inverted
+    vector<int> new_orientations;
+    calc_hex_orientations(new_orientations);
+    for (int i = 0; i < hexs.size(); ++i)
+        if (new_orientations[i] == 0 || new_orientations[i] != orientations[i]) {
+            for (int j = 0; j < n_nodes; ++j)
+                nodes.set_node(j, old_nodes[j]);
+            return 1;
+        }
+
+    nodes.calc_statistics();
+    tris.calc_appendices();
+    return 0;
+}
+
+void TetgenMesh::calc_hex_orientations(vector<int>& orientations) const {
+    // neighbouring nodes of every corner of hexahedron
+    static constexpr int corners[8][3] = { {1,3,4}, {2,0,5}, {3,1,6}, {0,2,7},
+                                           {7,5,0}, {4,6,1}, {5,7,2}, {6,4,3} };
+    const int n_hexs = hexs.size();
+    orientations.resize(n_hexs);
+
+    for (int i = 0; i < n_hexs; ++i) {
+        SimpleHex hex = hexs[i];
+        int n_positive = 0, n_negative = 0;
+
+        // the hexahedron is valid only if the Jacobian has the same sign in all of its corners
+        for (int c = 0; c < 8; ++c) {
+            Vec3 origin = nodes.get_vec(hex[c]);
+            Vec3 v1 = nodes.get_vec(hex[corners[c][0]]) - origin;
+            Vec3 v2 = nodes.get_vec(hex[corners[c][1]]) - origin;
+            Vec3 v3 = nodes.get_vec(hex[corners[c][2]]) - origin;
+            const double jacobian = v1.crossProduct(v2).dotProduct(v3);
+            if (jacobian > 0) n_positive++;
+            else if (jacobian < 0) n_negative++;
+        }
+
+        if (n_positive == 8) orientations[i] = 1;
+        else if (n_negative == 8) orientations[i] = -1;
+        else orientations[i] = 0;
+    }
+}
+
+int TetgenMesh::generate_union(const Medium& bulk, const Medium& surf, const Medium& vacuum,
+        const string& cmd, const int n_slabs)
+{
     const int n_bulk = bulk.size();
     const int n_surf = surf.size();
     const int n_vacuum = vacuum.size();
@@ -171,9 +372,80 @@ int TetgenMesh::generate_union(const Medium& bulk, const Medium& surf, const Med
     // Memorize the positions of different types of nodes to speed up later calculations
     nodes.save_indices(n_surf, n_bulk, n_vacuum);
 
+    if (n_slabs > 1)
+        return recalc_parallel(cmd, n_slabs);
     return recalc("Q", cmd);
 }
 
+void TetgenMesh::sort_spatial() {
+    const int n_nodes = nodes.size();
+    const int n_tets = tets.size();
+    const int node_min = nodes.indxs.tetgen_start;
+    double* points = tetIOout.pointlist;
+    int* corners = tetIOout.tetrahedronlist;
+
+    // scale the nodes into unit cube
+    Point3 pmin(DBL_MAX), pmax(-DBL_MAX);
+    for (int i = 0; i < n_nodes; ++i)
+        for (int j = 0; j < n_coordinates; ++j) {
+            pmin[j] = min(pmin[j], points[n_coordinates * i + j]);
+            pmax[j] = max(pmax[j], points[n_coordinates * i + j]);
+        }
+    Point3 scale;
+    for (int j = 0; j < n_coordinates; ++j)
+        scale[j] = pmax[j] > pmin[j] ? 1.0 / (pmax[j] - pmin[j]) : 0;
+
+    // order nodes added by Tetgen along Hilbert curve
+    vector<pair<uint64_t,int>> keys(max(0, n_nodes - node_min));
+    #pragma omp parallel for
+    for (int i = node_min; i < n_nodes; ++i) {
+        const double* p = &points[n_coordinates * i];
+        keys[i - node_min] = {hilbert_index((p[0] - pmin.x) * scale.x, (p[1] - pmin.y) * scale.y,
+                (p[2] - pmin.z) * scale.z), i};
+    }
+    sort(keys.begin(), keys.end());
+
+    vector<int> old2new(n_nodes);
+    iota(old2new.begin(), old2new.begin() + min(node_min, n_nodes), 0);
+    for (int i = node_min; i < n_nodes; ++i)
+        old2new[keys[i - node_min].second] = i;
+
+    vector<double> old_points(points, points + n_coordinates * n_nodes);
+    #pragma omp parallel for
+    for (int i = node_min; i < n_nodes; ++i) {
+        const int old = keys[i - node_min].second;
+        for (int j = 0; j < n_coordinates; ++j)
+            points[n_coordinates * i + j] = old_points[n_coordinates * old + j];
+    }
+    if (tetIOout.pointmarkerlist) {
+        vector<int> old_markers(tetIOout.pointmarkerlist, tetIOout.pointmarkerlist + n_nodes);
+        for (int i = node_min; i < n_nodes; ++i)
+            tetIOout.pointmarkerlist[i] = old_markers[keys[i - node_min].second];
+    }
+
+    // order tetrahedra along Hilbert curve by their centroids
+    vector<pair<uint64_t,int>> tet_keys(n_tets);
+    #pragma omp parallel for
+    for (int i = 0; i < n_tets; ++i) {
+        Point3 centroid(0);
+        for (int j = 0; j < n_nodes_per_tet; ++j) {
+            int& node = corners[n_nodes_per_tet * i + j];
+            node = old2new[node];
+            centroid += nodes[node];
+        }
+        centroid *= 1.0 / n_nodes_per_tet;
+        tet_keys[i] = {hilbert_index((centroid.x - pmin.x) * scale.x, (centroid.y - pmin.y) * scale.y,
+                (centroid.z - pmin.z) * scale.z), i};
+    }
+    sort(tet_keys.begin(), tet_keys.end());
+
+    vector<int> old_corners(corners, corners + n_nodes_per_tet * n_tets);
+    #pragma omp parallel for
+    for (int i = 0; i < n_tets; ++i)
+        for (int j = 0; j < n_nodes_per_tet; ++j)
+            corners[n_nodes_per_tet * i + j] = old_corners[n_nodes_per_tet * tet_keys[i].second + j];
+}
+
 int TetgenMesh::generate(const Medium& bulk, const Medium& surf, const Medium& vacuum, const Config& conf) {
     require(bulk.size() > 0,   "Empty mesh generators in bulk detected!");
     require(surf.size() > 0,   "Empty mesh generators on surface detected!");
@@ -189,15 +461,18 @@ int TetgenMesh::generate(const Medium& bulk, const Medium& surf, const Medium& v
     if (conf.geometry.element_volume != "") command += "a" + conf.geometry.element_volume;
 
     // Make union mesh where both vacuum and material domain are present
-    int err_code = generate_union(bulk, surf, vacuum, command);
+    int err_code = generate_union(bulk, surf, vacuum, command, conf.geometry.n_mesh_slabs);
     check_return(err_code, "Tetrahedrization failed with error code " + d2s(err_code));
 
+    // Order nodes and elements along space-filling curve
+    sort_spatial();
+
     // Mark tetrahedral mesh
     bool fail = mark_mesh();
     check_return(fail, "Mesh marking failed!");
 
     // Generate surface faces
-    err_code = generate_surface("rQB", "rQnn");
+    err_code = generate_surface();
     check_return(err_code, "Triangulation failed with error code " + d2s(err_code));
 
     // Smoothen surface faces
@@ -209,10 +484,30 @@ int TetgenMesh::generate(const Medium& bulk, const Medium& surf, const Medium& v
 
     // Convert tetrahedra & triangles to hexahedra & quadrangles
     fail = generate_hexahedra();
+
+    // Get rid of the data that is not needed anymore
+    compact();
     return fail;
 }
 
 int TetgenMesh::read(const string &file_name, const string &cmd) {
+    // native mesh is loaded without conversion and Tetgen calls;
+    // restart files without native mesh are read in the same way as msh-files
+    const string ftype = get_file_type(file_name);
+    if (ftype == "fmesh" || ftype == "restart") {
+        ifstream in(file_name);
+        check_return(!in, "File " + file_name + " cannot be opened!");
+
+        string str;
+        bool native = ftype == "fmesh";
+        while (!native && in >> str)
+            native = str == "$" + fmesh_label;
+        if (native) {
+            if (ftype == "restart") getline(in, str);
+            return read_fmesh(file_name, in);
+        }
+        check_return(ftype == "fmesh", "No native mesh found in " + file_name);
+    }
 
     // delete available mesh data
     clear();
@@ -242,6 +537,7 @@ int TetgenMesh::read(const string &file_name, const string &cmd) {
     nodes.calc_statistics();
     tris.calc_appendices();
 
+    compact();
     return 0;
 }
 
@@ -252,6 +548,44 @@ void TetgenMesh::clear() {
     tetIOout.initialize();
 }
 
+void TetgenMesh::compact() {
+    tetIOin.deinitialize();
+    tetIOin.initialize();
+
+    // Femocs keeps the markers and other appendices outside the Tetgen buffers
+    delete[] tetIOout.pointmarkerlist;          tetIOout.pointmarkerlist = NULL;
+    delete[] tetIOout.pointattributelist;       tetIOout.pointattributelist = NULL;
+    delete[] tetIOout.tetrahedronattributelist; tetIOout.tetrahedronattributelist = NULL;
+    delete[] tetIOout.trifacemarkerlist;        tetIOout.trifacemarkerlist = NULL;
+    delete[] tetIOout.edgemarkerlist;           tetIOout.edgemarkerlist = NULL;
+    delete[] tetIOout.edge2tetlist;             tetIOout.edge2tetlist = NULL;
+    tetIOout.numberofpointattributes = 0;
+    tetIOout.numberoftetrahedronattributes = 0;
+}
+
+size_t TetgenMesh::memory_usage(const tetgenio& io) const {
+    size_t n_bytes = 0;
+    if (io.pointlist) n_bytes += n_coordinates * io.numberofpoints * sizeof(REAL);
+    if (io.pointmarkerlist) n_bytes += io.numberofpoints * sizeof(int);
+    if (io.pointattributelist) n_bytes += io.numberofpointattributes * io.numberofpoints * sizeof(REAL);
+    if (io.tetrahedronlist) n_bytes += n_nodes_per_tet * io.numberoftetrahedra * sizeof(int);
+    if (io.tetrahedronattributelist)
+        n_bytes += io.numberoftetrahedronattributes * io.numberoftetrahedra * sizeof(REAL);
+    if (io.neighborlist) n_bytes += n_nodes_per_tet * io.numberoftetrahedra * sizeof(int);
+    if (io.trifacelist) n_bytes += n_nodes_per_tri * io.numberoftrifaces * sizeof(int);
+    if (io.trifacemarkerlist) n_bytes += io.numberoftrifaces * sizeof(int);
+    if (io.face2tetlist) n_bytes += n_tets_per_tri * io.numberoftrifaces * sizeof(int);
+    if (io.edgelist) n_bytes += n_nodes_per_edge * io.numberofedges * sizeof(int);
+    if (io.edgemarkerlist) n_bytes += io.numberofedges * sizeof(int);
+    if (io.edge2tetlist) n_bytes += io.numberofedges * sizeof(int);
+    return n_bytes;
+}
+
+size_t TetgenMesh::memory_usage() const {
+    return memory_usage(tetIOin) + memory_usage(tetIOout) + nodes.memory_usage() + edges.memory_usage()
+            + tris.memory_usage() + tets.memory_usage() + quads.memory_usage() + hexs.memory_usage();
+}
+
 int TetgenMesh::transfer(const bool write2read) {
     nodes.transfer(write2read);
     edges.transfer(write2read);
@@ -290,6 +624,353 @@ int TetgenMesh::recalc(const string& cmd1, const string& cmd2) {
     return 0;
 }
 
+int TetgenMesh::recalc_parallel(const string& cmd, const int n_slabs) {
+    vector<int> elems;
+    vector<TetFace> open_faces;
+    if (triangulate_slabs(elems, open_faces, n_slabs) || fill_slab_seams(elems, open_faces)) {
+        write_verbose_msg("Merging of Delaunay slabs failed; performing triangulation serially");
+        return recalc("Q", cmd);
+    }
+
+#if ASSERTMODE
+    expect(matches_serial_delaunay(elems), "Parallel Delaunay triangulation differs from serial one!");
+#endif
+
+    try {
+        tetgenio tetIOtemp;
+        tetIOtemp.numberofpoints = tetIOin.numberofpoints;
+        tetIOtemp.pointlist = new REAL[n_coordinates * tetIOtemp.numberofpoints];
+        copy_n(tetIOin.pointlist, n_coordinates * tetIOtemp.numberofpoints, tetIOtemp.pointlist);
+        tetIOtemp.numberofcorners = n_nodes_per_tet;
+        tetIOtemp.numberoftetrahedra = elems.size() / n_nodes_per_tet;
+        tetIOtemp.tetrahedronlist = new int[elems.size()];
+        copy(elems.begin(), elems.end(), tetIOtemp.tetrahedronlist);
+
+        tetrahedralize(const_cast<char*>(cmd.c_str()), &tetIOtemp, &tetIOout);
+        nodes.set_counter(tetIOout.numberofpoints);
+        edges.set_counter(tetIOout.numberofedges);
+        tris.set_counter(tetIOout.numberoftrifaces);
+        tets.set_counter(tetIOout.numberoftetrahedra);
+        tris.calc_statistics();
+        tets.calc_statistics();
+    }
+    catch (int e) { return e; }
+    return 0;
+}
+
+bool TetgenMesh::matches_serial_delaunay(const vector<int>& elems) const {
+    tetgenio serial_in, serial_out;
+    serial_in.numberofpoints = tetIOin.numberofpoints;
+    serial_in.pointlist = new REAL[n_coordinates * serial_in.numberofpoints];
+    copy_n(tetIOin.pointlist, n_coordinates * serial_in.numberofpoints, serial_in.pointlist);
+
+    try { tetrahedralize(const_cast<char*>("Q"), &serial_in, &serial_out); }
+    catch (int) { return false; }
+
+    const int n_elems = elems.size() / n_nodes_per_tet;
+    if (n_elems != serial_out.numberoftetrahedra) return false;
+
+    double volume = 0, serial_volume = 0;
+    for (int tet = 0; tet < n_elems; ++tet) {
+        const int* t = &elems[n_nodes_per_tet * tet];
+        volume += fabs(calc_orientation({t[0], t[1], t[2]}, t[3])) / 6.0;
+        t = &serial_out.tetrahedronlist[n_nodes_per_tet * tet];
+        serial_volume += fabs(calc_orientation({t[0], t[1], t[2]}, t[3])) / 6.0;
+    }
+
+    return fabs(volume - serial_volume) <= 1e-10 * serial_volume;
+}
+
+bool TetgenMesh::calc_circumsphere(const int* elem, Point3& centre, double& radius) const {
+    const double* points = tetIOin.pointlist;
+    Vec3 v0(points[n_coordinates*elem[0]], points[n_coordinates*elem[0]+1], points[n_coordinates*elem[0]+2]);
+    Vec3 v1 = Vec3(points[n_coordinates*elem[1]], points[n_coordinates*elem[1]+1], points[n_coordinates*elem[1]+2]) - v0;
+    Vec3 v2 = Vec3(points[n_coordinates*elem[2]], points[n_coordinates*elem[2]+1], points[n_coordinates*elem[2]+2]) - v0;
+    Vec3 v3 = Vec3(points[n_coordinates*elem[3]], points[n_coordinates*elem[3]+1], points[n_coordinates*elem[3]+2]) - v0;
+
+    Vec3 v2xv3 = v2.crossProduct(v3);
+    Vec3 v3xv1 = v3.crossProduct(v1);
+    Vec3 v1xv2 = v1.crossProduct(v2);
+    const double det = 2.0 * v1.dotProduct(v2xv3);
+    if (fabs(det) <= 1e-12 * v1.norm2() * v2.norm() * v3.norm()) return false;
+
+    Vec3 offset = (v2xv3 * v1.norm2() + v3xv1 * v2.norm2() + v1xv2 * v3.norm2()) * (1.0 / det);
+    centre = Point3(v0.x + offset.x, v0.y + offset.y, v0.z + offset.z);
+    radius = offset.norm();
+    return true;
+}
+
+double TetgenMesh::calc_orientation(const array<int,3>& face, const int node) const {
+    const double* points = tetIOin.pointlist;
+    Vec3 v0(points[n_coordinates*face[0]], points[n_coordinates*face[0]+1], points[n_coordinates*face[0]+2]);
+    Vec3 v1 = Vec3(points[n_coordinates*face[1]], points[n_coordinates*face[1]+1], points[n_coordinates*face[1]+2]) - v0;
+    Vec3 v2 = Vec3(points[n_coordinates*face[2]], points[n_coordinates*face[2]+1], points[n_coordinates*face[2]+2]) - v0;
+    Vec3 v3 = Vec3(points[n_coordinates*node], points[n_coordinates*node+1], points[n_coordinates*node+2]) - v0;
+    return v1.crossProduct(v2).dotProduct(v3);
+}
+
+void TetgenMesh::calc_faces(const vector<int>& elems, vector<TetFace>& faces) const {
+    const int n_elems = elems.size() / n_nodes_per_tet;
+    faces.resize(n_tris_per_tet * n_elems);
+
+#pragma omp parallel for
+    for (int tet = 0; tet < n_elems; ++tet) {
+        const int* t = &elems[n_nodes_per_tet * tet];
+        for (int i = 0; i < n_nodes_per_tet; ++i) {
+            array<int,3> key = {t[(i+1)%4], t[(i+2)%4], t[(i+3)%4]};
+            sort(key.begin(), key.end());
+            faces[n_tris_per_tet * tet + i] = {key, n_tris_per_tet * tet + i};
+        }
+    }
+    sort(faces.begin(), faces.end());
+}
+
+bool TetgenMesh::triangulate_slabs(vector<int>& elems, vector<TetFace>& open_faces, const int n_slabs) const {
+    const int n_nodes = tetIOin.numberofpoints;
+    const double* points = tetIOin.pointlist;
+
+    // the system is sliced along its longer horizontal dimension
+    double xmin = DBL_MAX, xmax = -DBL_MAX, ymin = DBL_MAX, ymax = -DBL_MAX;
+    for (int i = 0; i < n_nodes; ++i) {
+        xmin = min(xmin, points[n_coordinates*i]);   xmax = max(xmax, points[n_coordinates*i]);
+        ymin = min(ymin, points[n_coordinates*i+1]); ymax = max(ymax, points[n_coordinates*i+1]);
+    }
+    const int axis = xmax - xmin >= ymax - ymin ? 0 : 1;
+
+    // the borders of slabs are chosen so that each slab owns the same number of nodes
+    vector<double> coords(n_nodes);
+    for (int i = 0; i < n_nodes; ++i)
+        coords[i] = points[n_coordinates * i + axis];
+    sort(coords.begin(), coords.end());
+
+    vector<double> borders(n_slabs + 1);
+    borders[0] = -DBL_MAX;
+    borders[n_slabs] = DBL_MAX;
+    for (int s = 1; s < n_slabs; ++s)
+        borders[s] = coords[(long)s * n_nodes / n_slabs];
+    const double overlap = 0.2 * (coords.back() - coords.front()) / n_slabs;
+
+    vector<vector<int>> slab_elems(n_slabs);
+    vector<vector<TetFace>> slab_faces(n_slabs);
+#pragma omp parallel for schedule(dynamic)
+    for (int s = 0; s < n_slabs; ++s) {
+        const double slab_min = borders[s] - overlap;
+        const double slab_max = borders[s+1] + overlap;
+
+        vector<int> slab2mesh;
+        for (int i = 0; i < n_nodes; ++i) {
+            const double c = points[n_coordinates * i + axis];
+            if (c >= slab_min && c <= slab_max) slab2mesh.push_back(i);
+        }
+        if (slab2mesh.size() < n_nodes_per_tet) continue;
+
+        tetgenio slab_in, slab_out;
+        slab_in.numberofpoints = slab2mesh.size();
+        slab_in.pointlist = new REAL[n_coordinates * slab_in.numberofpoints];
+        for (int i = 0; i < slab_in.numberofpoints; ++i)
+            for (int j = 0; j < n_coordinates; ++j)
+                slab_in.pointlist[n_coordinates * i + j] = points[n_coordinates * slab2mesh[i] + j];
+
+        try { tetrahedralize(const_cast<char*>("Qn"), &slab_in, &slab_out); }
+        // degenerate slab, e.g with coplanar nodes only, is left for the seams
+        catch (int) { continue; }
+
+        // The tetrahedron is Delaunay also in the whole system if its circumsphere doesn't reach
+        // beyond the slab. Cospherical tetrahedra have common circumcentre, therefore owning
+        // the tetrahedra by their circumcentre keeps such clusters consistent. Due to round-off
+        // the centres of the cluster scatter a bit, so the clusters on the border are left for the seams.
+        const int n_slab_elems = slab_out.numberoftetrahedra;
+        vector<int> elem2accepted(n_slab_elems, -1);
+        for (int tet = 0; tet < n_slab_elems; ++tet) {
+            int elem[n_nodes_per_tet];
+            for (int j = 0; j < n_nodes_per_tet; ++j)
+                elem[j] = slab2mesh[slab_out.tetrahedronlist[n_nodes_per_tet * tet + j]];
+
+            Point3 centre;
+            double radius;
+            if (!calc_circumsphere(elem, centre, radius)) continue;
+            const double c = centre[axis];
+            const double eps = 1e-6 * radius;
+            if (c > borders[s] + eps && c < borders[s+1] - eps && c - radius > slab_min && c + radius < slab_max) {
+                elem2accepted[tet] = slab_elems[s].size() / n_nodes_per_tet;
+                slab_elems[s].insert(slab_elems[s].end(), elem, elem + n_nodes_per_tet);
+            }
+        }
+
+        // the faces between accepted and rejected tetrahedra are open,
+        // unless some other slab accepted the tetrahedron on the other side
+        for (int tet = 0; tet < n_slab_elems; ++tet) {
+            if (elem2accepted[tet] < 0) continue;
+            const int* t = &slab_elems[s][n_nodes_per_tet * elem2accepted[tet]];
+            for (int i = 0; i < n_nodes_per_tet; ++i) {
+                const int nbor = slab_out.neighborlist[n_nodes_per_tet * tet + i];
+                if (nbor >= 0 && elem2accepted[nbor] >= 0) continue;
+                array<int,3> key = {t[(i+1)%4], t[(i+2)%4], t[(i+3)%4]};
+                sort(key.begin(), key.end());
+                slab_faces[s].push_back({key, n_tris_per_tet * elem2accepted[tet] + i});
+            }
+        }
+    }
+
+    elems.clear();
+    vector<TetFace> faces;
+    for (int s = 0; s < n_slabs; ++s) {
+        const int offset = elems.size();
+        for (const TetFace& face : slab_faces[s])
+            faces.push_back({face.first, face.second + offset});
+        elems.insert(elems.end(), slab_elems[s].begin(), slab_elems[s].end());
+    }
+
+    // open faces that are shared between slabs appear twice
+    sort(faces.begin(), faces.end());
+    open_faces.clear();
+    const int n_faces = faces.size();
+    for (int i = 0; i < n_faces; ) {
+        int j = i + 1;
+        while (j < n_faces && faces[j].first == faces[i].first) j++;
+        if (j - i > 2) return true;
+        if (j - i == 1) open_faces.push_back(faces[i]);
+        i = j;
+    }
+
+    return false;
+}
+
+bool TetgenMesh::fill_slab_seams(vector<int>& elems, vector<TetFace>& open_faces) const {
+    static constexpr int max_rounds = 10;
+    const int n_nodes = tetIOin.numberofpoints;
+    const double* points = tetIOin.pointlist;
+
+    for (int round = 0; round < max_rounds; ++round) {
+        // The seams between slabs are filled with Delaunay triangulation of the nodes that are
+        // not used yet and the nodes on open faces. Its tetrahedra inside the seams are also
+        // present in the Delaunay triangulation of the whole system.
+        vector<char> seam_node(n_nodes, 1);
+        for (int node : elems) seam_node[node] = 0;
+        for (const TetFace& face : open_faces)
+            for (int node : face.first) seam_node[node] = 1;
+
+        vector<int> seam2mesh;
+        for (int i = 0; i < n_nodes; ++i)
+            if (seam_node[i]) seam2mesh.push_back(i);
+        if (seam2mesh.size() < n_nodes_per_tet) return open_faces.size() > 0;
+
+        tetgenio seam_in, seam_out;
+        seam_in.numberofpoints = seam2mesh.size();
+        seam_in.pointlist = new REAL[n_coordinates * seam_in.numberofpoints];
+        for (int i = 0; i < seam_in.numberofpoints; ++i)
+            for (int j = 0; j < n_coordinates; ++j)
+                seam_in.pointlist[n_coordinates * i + j] = points[n_coordinates * seam2mesh[i] + j];
+
+        try { tetrahedralize(const_cast<char*>("Qn"), &seam_in, &seam_out); }
+        catch (int) { return true; }
+
+        const int n_seam_elems = seam_out.numberoftetrahedra;
+        vector<int> seam_elems(n_nodes_per_tet * n_seam_elems);
+        for (int i = 0; i < n_nodes_per_tet * n_seam_elems; ++i)
+            seam_elems[i] = seam2mesh[seam_out.tetrahedronlist[i]];
+
+        vector<TetFace> seam_faces;
+        calc_faces(seam_elems, seam_faces);
+
+        // seam tetrahedron behind the open face starts the hole;
+        // open face without such tetrahedron must be on the convex hull
+        vector<char> in_hole(n_seam_elems, 0);
+        vector<int> frontier;
+        vector<char> mismatch(elems.size() / n_nodes_per_tet, 0);
+        bool matched = true;
+        for (const TetFace& face : open_faces) {
+            const double side = calc_orientation(face.first, elems[face.second]);
+            auto first = lower_bound(seam_faces.begin(), seam_faces.end(), TetFace(face.first, INT_MIN));
+            auto last = upper_bound(seam_faces.begin(), seam_faces.end(), TetFace(face.first, INT_MAX));
+            bool in_seam = false;
+            for (auto it = first; it != last; ++it) {
+                const int tet = it->second / n_tris_per_tet;
+                if (side * calc_orientation(face.first, seam_elems[it->second]) >= 0) continue;
+                in_seam = true;
+                if (!in_hole[tet]) {
+                    in_hole[tet] = 1;
+                    frontier.push_back(tet);
+                }
+            }
+            const bool on_hull = last - first == 1 && seam_out.neighborlist[first->second] < 0;
+            if (!in_seam && !on_hull) {
+                mismatch[face.second / n_tris_per_tet] = 1;
+                matched = false;
+            }
+        }
+
+        // Cospherical nodes have many Delaunay triangulations, so the slab and the seam may
+        // split the common facet of such cluster differently. The slab tetrahedra on such facets
+        // are moved into the seam, until both sides of every open face agree.
+        if (!matched) {
+            vector<int> kept;
+            kept.reserve(elems.size());
+            for (size_t tet = 0; tet < mismatch.size(); ++tet)
+                if (!mismatch[tet])
+                    kept.insert(kept.end(), &elems[n_nodes_per_tet * tet], &elems[n_nodes_per_tet * (tet+1)]);
+            elems.swap(kept);
+
+            vector<TetFace> faces;
+            calc_faces(elems, faces);
+            open_faces.clear();
+            const int n_faces = faces.size();
+            for (int i = 0; i < n_faces; ) {
+                int j = i + 1;
+                while (j < n_faces && faces[j].first == faces[i].first) j++;
+                if (j - i == 1) open_faces.push_back(faces[i]);
+                i = j;
+            }
+            continue;
+        }
+
+        // flood the holes without crossing the open faces
+        while (frontier.size() > 0) {
+            vector<int> next;
+            for (int tet : frontier)
+                for (int i = 0; i < n_nodes_per_tet; ++i) {
+                    const int nbor = seam_out.neighborlist[n_nodes_per_tet * tet + i];
+                    if (nbor < 0 || in_hole[nbor]) continue;
+
+                    const int* t = &seam_elems[n_nodes_per_tet * tet];
+                    array<int,3> key = {t[(i+1)%4], t[(i+2)%4], t[(i+3)%4]};
+                    sort(key.begin(), key.end());
+                    auto it = lower_bound(open_faces.begin(), open_faces.end(), TetFace(key, INT_MIN));
+                    if (it != open_faces.end() && it->first == key) continue;
+
+                    in_hole[nbor] = 1;
+                    next.push_back(nbor);
+                }
+            frontier.swap(next);
+        }
+
+        for (int tet = 0; tet < n_seam_elems; ++tet)
+            if (in_hole[tet])
+                elems.insert(elems.end(), &seam_elems[n_nodes_per_tet * tet], &seam_elems[n_nodes_per_tet * (tet+1)]);
+
+        // The faces of merged tetrahedra on the convex hull are open faces, so the seam nodes
+        // contain all the hull nodes and the seam triangulation, that was needed anyway to fill
+        // the seams, spans the whole hull. Therefore the tetrahedra must cover the same volume.
+        const double hull_volume = calc_volume(seam_elems);
+        return fabs(calc_volume(elems) - hull_volume) > 1e-8 * hull_volume;
+    }
+
+    return true;
+}
+
+double TetgenMesh::calc_volume(const vector<int>& elems) const {
+    const int n_elems = elems.size() / n_nodes_per_tet;
+    double volume = 0;
+
+#pragma omp parallel for reduction(+:volume)
+    for (int tet = 0; tet < n_elems; ++tet) {
+        const int* t = &elems[n_nodes_per_tet * tet];
+        volume += fabs(calc_orientation({t[0], t[1], t[2]}, t[3]));
+    }
+    return volume / 6.0;
+}
+
+
 void TetgenMesh::group_hexahedra() {
     const int node_min = nodes.indxs.tetnode_start;
     const int node_max = nodes.indxs.tetnode_end;
@@ -325,11 +1006,7 @@ void TetgenMesh::group_hexahedra() {
 }
 
 bool TetgenMesh::generate_hexahedra() {
-    tethex::Mesh hexmesh;
-    hexmesh.read_femocs(this);
-    hexmesh.convert();
-    hexmesh.export_femocs(this);
-
+    split_into_hexahedra();
     group_hexahedra();
     calc_quad2hex2quad_mapping();
     nodes.calc_statistics();
@@ -337,27 +1014,249 @@ bool TetgenMesh::generate_hexahedra() {
     return 0;
 }
 
-int TetgenMesh::generate_surface(const string& cmd1, const string& cmd2) {
-    TetgenMesh vacuum;
-    vector<bool> tet_mask = vector_equal(tets.get_markers(), TYPES.VACUUM);
+void TetgenMesh::split_into_hexahedra() {
+    const int n_tetnodes = nodes.size();
+    const int n_tets = tets.size();
+    const int n_tris = tris.size();
+    require(n_tets > 0, "There are no tetrahedra to split!");
+
+    typedef array<int,3> FaceKey;
+    auto edge_key = [](const int n1, const int n2) -> uint64_t {
+        return n1 < n2 ? (uint64_t(n1) << 32) | uint64_t(n2) : (uint64_t(n2) << 32) | uint64_t(n1);
+    };
+    auto face_key = [](const int n1, const int n2, const int n3) -> FaceKey {
+        FaceKey key = {n1, n2, n3};
+        sort(key.begin(), key.end());
+        return key;
+    };
+
+    // collect the edges and faces of tetrahedra and number them by sorting & removing duplicates
+    vector<uint64_t> edge_keys(n_edges_per_tet * n_tets);
+    vector<FaceKey> face_keys(n_tris_per_tet * n_tets);
+
+#pragma omp parallel for
+    for (int tet = 0; tet < n_tets; ++tet) {
+        SimpleElement t = tets[tet];
+        int e = n_edges_per_tet * tet;
+        for (int i = 0; i < n_nodes_per_tet; ++i) {
+            face_keys[n_tris_per_tet * tet + i] = face_key(t[(i+1)%4], t[(i+2)%4], t[(i+3)%4]);
+            for (int j = i + 1; j < n_nodes_per_tet; ++j)
+                edge_keys[e++] = edge_key(t[i], t[j]);
+        }
+    }
 
-    // Transfer vacuum nodes and tetrahedra
-    vacuum.nodes.copy(this->nodes);
-    vacuum.tets.copy(this->tets, tet_mask);
+    sort(edge_keys.begin(), edge_keys.end());
+    edge_keys.erase(unique(edge_keys.begin(), edge_keys.end()), edge_keys.end());
+    sort(face_keys.begin(), face_keys.end());
+    face_keys.erase(unique(face_keys.begin(), face_keys.end()), face_keys.end());
+
+    const int n_edges = edge_keys.size();
+    const int n_faces = face_keys.size();
+    const int edge_start = n_tetnodes;
+    const int face_start = edge_start + n_edges;
+    const int tet_start = face_start + n_faces;
+    const int n_nodes = tet_start + n_tets;
+
+    // indices of the nodes in the middle of edges and in the centroid of faces
+    auto edge_node = [&](const int n1, const int n2) -> int {
+        const uint64_t key = edge_key(n1, n2);
+        return edge_start + lower_bound(edge_keys.begin(), edge_keys.end(), key) - edge_keys.begin();
+    };
+    auto face_node = [&](const int n1, const int n2, const int n3) -> int {
+        const FaceKey key = face_key(n1, n2, n3);
+        return face_start + lower_bound(face_keys.begin(), face_keys.end(), key) - face_keys.begin();
+    };
+
+    // calculate the locations of new nodes
+    vector<Point3> points(n_nodes - n_tetnodes);
+
+#pragma omp parallel for
+    for (int i = 0; i < n_edges; ++i) {
+        const int n1 = edge_keys[i] >> 32;
+        const int n2 = edge_keys[i] & 0xFFFFFFFF;
+        points[i] = (nodes[n1] + nodes[n2]) / 2.0;
+    }
 
-    // calculate surface triangles
-    int error_code = vacuum.recalc(cmd1);
-    if (error_code) return error_code;
+#pragma omp parallel for
+    for (int i = 0; i < n_faces; ++i)
+        points[n_edges + i] = (nodes[face_keys[i][0]] + nodes[face_keys[i][1]] + nodes[face_keys[i][2]]) / 3.0;
+
+#pragma omp parallel for
+    for (int i = 0; i < n_tets; ++i)
+        points[n_edges + n_faces + i] = tets.get_centroid(i);
+
+    // split every tetrahedron into four hexahedra in the same order as tethex does it;
+    // the vertex order is fixed to get positive volume in deal.II
+    vector<SimpleHex> hex_cells(n_hexs_per_tet * n_tets);
+
+#pragma omp parallel for
+    for (int tet = 0; tet < n_tets; ++tet) {
+        SimpleElement t = tets[tet];
+        for (int i = 0; i < n_nodes_per_tet; ++i) {
+            const int v = t[i], w0 = t[(i+1)%4], w1 = t[(i+2)%4], w2 = t[(i+3)%4];
+            SimpleHex hex(v, edge_node(v, w0), face_node(v, w0, w1), edge_node(v, w1),
+                    edge_node(v, w2), face_node(v, w0, w2), tet_start + tet, face_node(v, w1, w2));
+
+            Vec3 v1 = Vec3(points[hex[1] - n_tetnodes]) - nodes.get_vec(v);
+            Vec3 v3 = Vec3(points[hex[3] - n_tetnodes]) - nodes.get_vec(v);
+            Vec3 v4 = Vec3(points[hex[4] - n_tetnodes]) - nodes.get_vec(v);
+            if (v1.crossProduct(v3).dotProduct(v4) > 0)
+                hex = SimpleHex(hex[4], hex[5], hex[6], hex[7], hex[0], hex[1], hex[2], hex[3]);
+
+            hex_cells[n_hexs_per_tet * tet + i] = hex;
+        }
+    }
 
-    // copy the triangles that are not on the simubox perimeter to input tetIO
-    vacuum.tris.calc_appendices();
-    const int n_surf_faces = tris.copy_surface(vacuum.tris, nodes.stat);
+    // split every triangle into three quadrangles;
+    // the vertex order is fixed by the xy-projection like in tethex
+    vector<SimpleQuad> quad_cells(n_quads_per_tri * n_tris);
+
+#pragma omp parallel for
+    for (int tri = 0; tri < n_tris; ++tri) {
+        SimpleFace t = tris[tri];
+        const int face = face_node(t[0], t[1], t[2]);
+        for (int i = 0; i < n_nodes_per_tri; ++i) {
+            const int v = t[i], w0 = t[(i+1)%3], w1 = t[(i+2)%3];
+            SimpleQuad quad(v, edge_node(v, w0), face, edge_node(v, w1));
+
+            // vertices in deal.II order
+            Point3 p[4] = { nodes[v], points[quad[1] - n_tetnodes],
+                    points[quad[3] - n_tetnodes], points[quad[2] - n_tetnodes] };
+            const double area = -p[1].x * p[0].y + p[1].x * p[3].y + p[0].y * p[2].x + p[0].x * p[1].y
+                    - p[0].x * p[2].y - p[1].y * p[3].x - p[2].x * p[3].y + p[3].x * p[2].y;
+            if (area < 0)
+                quad = SimpleQuad(quad[0], quad[3], quad[2], quad[1]);
+
+            quad_cells[n_quads_per_tri * tri + i] = quad;
+        }
+    }
 
-    // transfer elements and nodes to input
-    nodes.transfer(false);
-    tets.transfer(false);
+    // export the nodes; the marker shows the type of the node
+    nodes.init(n_nodes);
+    nodes.init_markers(n_nodes);
+    for (int i = 0; i < n_tetnodes; ++i) {
+        nodes.append(nodes[i]);
+        nodes.append_marker(TYPES.TETNODE);
+    }
+    for (int i = 0; i < n_nodes - n_tetnodes; ++i) {
+        nodes.append(points[i]);
+        if (i < n_edges) nodes.append_marker(TYPES.EDGECENTROID);
+        else if (i < n_edges + n_faces) nodes.append_marker(TYPES.FACECENTROID);
+        else nodes.append_marker(TYPES.TETCENTROID);
+    }
+    nodes.transfer();
+    nodes.save_hex_indices({n_tetnodes, n_edges, n_faces, n_tets});
+
+    // export the quadrangles and hexahedra; the marker is inherited from the parent cell
+    const bool tri_markers = n_tris == tris.get_n_markers();
+    quads.init(quad_cells.size());
+    quads.init_markers(quad_cells.size());
+    for (size_t i = 0; i < quad_cells.size(); ++i) {
+        quads.append(quad_cells[i]);
+        quads.append_marker(tri_markers ? tris.get_marker(quads.to_tri(i)) : 0);
+    }
 
-    return calc_tri2tet2tri_mapping(cmd2, n_surf_faces);
+    const bool tet_markers = n_tets == tets.get_n_markers();
+    hexs.init(hex_cells.size());
+    hexs.init_markers(hex_cells.size());
+    for (size_t i = 0; i < hex_cells.size(); ++i) {
+        hexs.append(hex_cells[i]);
+        hexs.append_marker(tet_markers ? tets.get_marker(hexs.to_tet(i)) : 0);
+    }
+}
+
+int TetgenMesh::generate_surface() {
+    const int n_tets = tets.size();
+
+    // list the faces of tetrahedra as sorted node triplets together with their location in tet;
+    // after sorting the shared faces are next to each other
+    vector<TetFace> tet_faces(n_tris_per_tet * n_tets);
+
+#pragma omp parallel for
+    for (int tet = 0; tet < n_tets; ++tet) {
+        SimpleElement t = tets[tet];
+        for (int i = 0; i < n_nodes_per_tet; ++i) {
+            array<int,3> key = {(int)t[(i+1)%4], (int)t[(i+2)%4], (int)t[(i+3)%4]};
+            sort(key.begin(), key.end());
+            tet_faces[n_tris_per_tet * tet + i] = TetFace(key, n_tris_per_tet * tet + i);
+        }
+    }
+    sort(tet_faces.begin(), tet_faces.end());
+
+    // neighbour i of tetrahedron is opposite to its node i; -1 means there's no neighbour
+    int* nborlist = new int[n_tris_per_tet * n_tets];
+    fill_n(nborlist, n_tris_per_tet * n_tets, -1);
+
+    // find the faces between vacuum and bulk tetrahedra and the vacuum faces on the convex hull
+    vector<SimpleFace> faces;
+    vector<array<int,2>> face2tets;
+
+    const int n_faces = tet_faces.size();
+    for (int i = 0; i < n_faces; ++i) {
+        int face1 = tet_faces[i].second, face2 = -1;
+        if (i + 1 < n_faces && tet_faces[i].first == tet_faces[i+1].first) {
+            face2 = tet_faces[++i].second;
+            nborlist[face1] = face2 / n_tris_per_tet;
+            nborlist[face2] = face1 / n_tris_per_tet;
+        }
+
+        const bool vacuum1 = tets.get_marker(face1 / n_tris_per_tet) == TYPES.VACUUM;
+        const bool vacuum2 = face2 >= 0 && tets.get_marker(face2 / n_tris_per_tet) == TYPES.VACUUM;
+        if (vacuum1 == vacuum2) continue;
+        if (vacuum2) swap(face1, face2);
+
+        // like Tetgen, orient the face so that its norm points into vacuum tetrahedron
+        const int tet = face1 / n_tris_per_tet, node = face1 % n_tris_per_tet;
+        SimpleElement t = tets[tet];
+        SimpleFace face(t[(node+1)%4], t[(node+2)%4], t[(node+3)%4]);
+        Vec3 v0 = nodes.get_vec(face[0]);
+        Vec3 e1 = nodes.get_vec(face[1]) - v0;
+        Vec3 e2 = nodes.get_vec(face[2]) - v0;
+        Vec3 norm = e1.crossProduct(e2);
+        if (norm.dotProduct(nodes.get_vec(t[node]) - v0) < 0)
+            face = SimpleFace(face[0], face[2], face[1]);
+
+        faces.push_back(face);
+        face2tets.push_back({tet, face2 < 0 ? -1 : face2 / n_tris_per_tet});
+    }
+
+    // ignore the faces on the sides of simulation cell
+    double edgemin = DBL_MAX;
+    for (SimpleFace face : faces)
+        for (int i = 0; i < n_nodes_per_tri; ++i)
+            edgemin = min(edgemin, nodes[face[i]].distance2(nodes[face[(i+1)%3]]));
+    const double eps = 0.01 * sqrt(edgemin);
+
+    vector<bool> tri_mask(faces.size());
+    for (size_t i = 0; i < faces.size(); ++i) {
+        Point3 centroid = (nodes[faces[i][0]] + nodes[faces[i][1]] + nodes[faces[i][2]]) / 3.0;
+        tri_mask[i] = !(on_boundary(centroid.x, nodes.stat.xmin, nodes.stat.xmax, eps) ||
+                on_boundary(centroid.y, nodes.stat.ymin, nodes.stat.ymax, eps) ||
+                on_boundary(centroid.z, nodes.stat.zmin, nodes.stat.zmax, eps));
+    }
+
+    // store the surface faces together with the mapping between triangles and tetrahedra
+    const int n_surf_faces = vector_sum(tri_mask);
+    int* face2tetlist = new int[n_tets_per_tri * n_surf_faces];
+    tris.init(n_surf_faces);
+    for (size_t i = 0, j = 0; i < faces.size(); ++i)
+        if (tri_mask[i]) {
+            tris.append(faces[i]);
+            face2tetlist[j++] = face2tets[i][0];
+            face2tetlist[j++] = face2tets[i][1];
+        }
+    tris.transfer();
+    tris.calc_statistics();
+
+    delete[] tetIOout.face2tetlist;
+    delete[] tetIOout.neighborlist;
+    tetIOout.face2tetlist = face2tetlist;
+    tetIOout.neighborlist = nborlist;
+
+    // calculate mapping from tetrahedra to triangles
+    calc_tet2tri_mapping();
+
+    return 0;
 }
 
 void TetgenMesh::generate_manual_surface() {
@@ -408,6 +1307,47 @@ void TetgenMesh::generate_manual_surface() {
         }
 }
 
+void TetgenMesh::export_dealii(vector<dealii::Point<3>>& vertices, vector<dealii::CellData<3>>& cells,
+        const int region) const
+{
+    require(region == TYPES.VACUUM || region == TYPES.BULK, "Unimplemented region: " + d2s(region));
+    static constexpr int ucd_to_deal[n_nodes_per_hex] = {0, 1, 5, 4, 2, 3, 7, 6};
+    const int sign = region == TYPES.VACUUM ? 1 : -1;
+    const int n_nodes = nodes.size();
+    const int n_hexs = hexs.size();
+
+    // number the nodes of the domain in the same order as they are in the mesh
+    vector<int> node2vertex(n_nodes, -1);
+    int n_cells = 0;
+    for (int i = 0; i < n_hexs; ++i)
+        if (sign * hexs.get_marker(i) > 0) {
+            n_cells++;
+            for (int node : hexs[i])
+                node2vertex[node] = 0;
+        }
+
+    int n_vertices = 0;
+    for (int& v : node2vertex)
+        if (v == 0) v = n_vertices++;
+
+    vertices.resize(n_vertices);
+    for (int i = 0; i < n_nodes; ++i)
+        if (node2vertex[i] >= 0) {
+            Point3 p = nodes[i];
+            vertices[node2vertex[i]] = dealii::Point<3>(p.x, p.y, p.z);
+        }
+
+    cells.clear();
+    cells.reserve(n_cells);
+    for (int i = 0; i < n_hexs; ++i)
+        if (sign * hexs.get_marker(i) > 0) {
+            cells.push_back(dealii::CellData<3>());
+            SimpleHex hex = hexs[i];
+            for (int v = 0; v < n_nodes_per_hex; ++v)
+                cells.back().vertices[ucd_to_deal[v]] = node2vertex[hex[v]];
+        }
+}
+
 int TetgenMesh::tri2tet(const int tri, const int region) const {
     if (region == TYPES.VACUUM) {
         for (int tet : tris.to_tets(tri))
@@ -438,14 +1378,34 @@ int TetgenMesh::quad2hex(const int quad, const int region) const {
     return -1;
 }
 
+void TetgenMesh::invert_map(const vector<array<int,2>>& map, const int n_cells,
+        vector<int>& offsets, vector<int>& inverse) const
+{
+    const int n_map = map.size();
+
+    offsets = vector<int>(n_cells + 1, 0);
+    for (const array<int,2>& cells : map)
+        for (int cell : cells)
+            if (cell >= 0) offsets[cell + 1]++;
+    for (int i = 0; i < n_cells; ++i)
+        offsets[i + 1] += offsets[i];
+
+    vector<int> cursor(offsets.begin(), offsets.end() - 1);
+    inverse.resize(offsets[n_cells]);
+    for (int i = 0; i < n_map; ++i)
+        for (int cell : map[i])
+            if (cell >= 0) inverse[cursor[cell]++] = i;
+}
+
 void TetgenMesh::calc_tet2tri_mapping() {
-    vector<vector<int>> tet2tri_map(tets.size());
-    for (int i = 0; i < tris.size(); ++i) {
-        for (int tet : tris.to_tets(i))
-            if (tet >= 0)
-                tet2tri_map[tet].push_back(i);
-    }
-    tets.store_map(tet2tri_map);
+    const int n_tris = tris.size();
+    vector<array<int,2>> tri2tet_map(n_tris);
+    for (int i = 0; i < n_tris; ++i)
+        tri2tet_map[i] = tris.to_tets(i);
+
+    vector<int> offsets, tet2tri_map;
+    invert_map(tri2tet_map, tets.size(), offsets, tet2tri_map);
+    tets.store_map(offsets, tet2tri_map);
 }
 
 void TetgenMesh::read_tri2tet2tri_mapping(const string &filename) {
@@ -514,7 +1474,6 @@ void TetgenMesh::calc_quad2hex2quad_mapping() {
     const int n_hexs = hexs.size();
 
     vector<array<int,2>> quad2hex_map = vector<array<int,2>>(n_quads, {-1,-1});
-    vector<vector<int>> hex2quad_map = vector<vector<int>>(n_hexs);
 
     for (int quad = 0; quad < n_quads; ++quad) {
         SimpleQuad squad = quads[quad];
@@ -533,17 +1492,17 @@ void TetgenMesh::calc_quad2hex2quad_mapping() {
                     n_common_nodes += squad == node;
 
                 // quad belongs to hex, if they share 4 nodes
-                if (n_common_nodes == n_nodes_per_quad) {
+                if (n_common_nodes == n_nodes_per_quad)
                     quad2hex_map[quad][region++] = hex;
-                    hex2quad_map[hex].push_back(quad);
-                }
             }
         }
     }
 
     // store the mapping on the cells side
+    vector<int> offsets, hex2quad_map;
+    invert_map(quad2hex_map, n_hexs, offsets, hex2quad_map);
     quads.store_map(quad2hex_map);
-    hexs.store_map(hex2quad_map);
+    hexs.store_map(offsets, hex2quad_map);
 }
 
 int TetgenMesh::separate_meshes(TetgenMesh &bulk, TetgenMesh &vacuum, const string &cmd) {
@@ -656,6 +1615,211 @@ void TetgenMesh::write_bin(ofstream &out) const {
     out.close();
 }
 
+void TetgenMesh::write_restart(ofstream &out) const {
+    out << "$" << fmesh_label << "\n";
+    write_fmesh(out);
+    out << "\n$End" << fmesh_label << "\n";
+}
+
+void TetgenMesh::write_fmesh(ofstream &out) const {
+    const int n_nodes = nodes.size();
+    const int n_tris = tris.size();
+    const int n_tets = tets.size();
+    const int n_quads = quads.size();
+    const int n_hexs = hexs.size();
+
+    require(nodes.get_n_markers() == n_nodes && tris.get_n_markers() == n_tris && tets.get_n_markers() == n_tets
+            && quads.get_n_markers() == n_quads && hexs.get_n_markers() == n_hexs,
+            "Native mesh file requires all the nodes and cells to be marked!");
+
+    // text header is followed by the data arrays in the same layout as they are in memory;
+    // every array starts at aligned position, so that the file can be used via memory mapping
+    out << fmesh_label << " " << fmesh_version << " " << sizeof(int) << " " << sizeof(double) << " "
+            << n_nodes << " " << n_tris << " " << n_tets << " " << n_quads << " " << n_hexs << " "
+            << GLOBALS.TIME << " " << GLOBALS.TIMESTEP << "\n";
+
+    auto pad = [&out]() {
+        for (long i = out.tellp(); i % fmesh_alignment != 0; ++i)
+            out.put('\0');
+    };
+    auto write_block = [&out, &pad](const void* data, const size_t n_bytes) {
+        pad();
+        out.write((const char*)data, n_bytes);
+    };
+
+    write_block(&nodes.indxs, sizeof(TetgenNodes::Indexes));
+    write_block(&nodes.stat, sizeof(TetgenNodes::Stat));
+    write_block(tetIOout.pointlist, 3 * n_nodes * sizeof(REAL));
+    write_block(nodes.get_markers()->data(), n_nodes * sizeof(int));
+
+    write_block(tetIOout.trifacelist, n_nodes_per_tri * n_tris * sizeof(int));
+    write_block(tris.get_markers()->data(), n_tris * sizeof(int));
+    write_block(tetIOout.face2tetlist, n_tets_per_tri * n_tris * sizeof(int));
+
+    write_block(tetIOout.tetrahedronlist, n_nodes_per_tet * n_tets * sizeof(int));
+    write_block(tets.get_markers()->data(), n_tets * sizeof(int));
+    write_block(tetIOout.neighborlist, n_tris_per_tet * n_tets * sizeof(int));
+
+    pad();
+    for (int i = 0; i < n_quads; ++i) {
+        SimpleQuad quad = quads[i];
+        out.write((char*)&quad, sizeof(SimpleQuad));
+    }
+    write_block(quads.get_markers()->data(), n_quads * sizeof(int));
+    pad();
+    for (int i = 0; i < n_quads; ++i) {
+        array<int,2> quad2hex = quads.to_hexs(i);
+        out.write((char*)quad2hex.data(), n_hexs_per_quad * sizeof(int));
+    }
+
+    pad();
+    for (int i = 0; i < n_hexs; ++i) {
+        SimpleHex hex = hexs[i];
+        out.write((char*)&hex, sizeof(SimpleHex));
+    }
+    write_block(hexs.get_markers()->data(), n_hexs * sizeof(int));
+}
+
+int TetgenMesh::read_fmesh(const string& file_name, ifstream &in) {
+    string label;
+    int version, int_size, double_size, n_nodes, n_tris, n_tets, n_quads, n_hexs;
+    double time;
+    int timestep;
+    in >> label >> version >> int_size >> double_size
+        >> n_nodes >> n_tris >> n_tets >> n_quads >> n_hexs >> time >> timestep;
+    in.get(); // skip new line
+
+    check_return(!in || label != fmesh_label || version != fmesh_version,
+            "Unknown native mesh format in " + file_name);
+    check_return(int_size != sizeof(int) || double_size != sizeof(double),
+            "Native mesh file " + file_name + " is not portable to this machine!");
+    check_return(n_nodes <= 0 || n_tris < 0 || n_tets <= 0, "Invalid size of native mesh: #nodes="
+            + d2s(n_nodes) + ", #tris=" + d2s(n_tris) + ", #tets=" + d2s(n_tets));
+    check_return(n_quads != n_quads_per_tri * n_tris || n_hexs != n_hexs_per_tet * n_tets,
+            "Mismatch between # quads & hexs and # tris & tets in native mesh!");
+
+    // sizes of the data arrays in the order they are stored
+    const vector<size_t> block_sizes = {
+        sizeof(TetgenNodes::Indexes), sizeof(TetgenNodes::Stat),
+        3 * n_nodes * sizeof(REAL), n_nodes * sizeof(int),
+        n_nodes_per_tri * n_tris * sizeof(int), n_tris * sizeof(int), n_tets_per_tri * n_tris * sizeof(int),
+        n_nodes_per_tet * n_tets * sizeof(int), n_tets * sizeof(int), n_tris_per_tet * n_tets * sizeof(int),
+        n_quads * sizeof(SimpleQuad), n_quads * sizeof(int), n_hexs_per_quad * n_quads * sizeof(int),
+        n_hexs * sizeof(SimpleHex), n_hexs * sizeof(int)
+    };
+    auto align = [](const size_t pos) { return (pos + fmesh_alignment - 1) / fmesh_alignment * fmesh_alignment; };
+
+    size_t data_end = in.tellg();
+    for (size_t n_bytes : block_sizes)
+        data_end = align(data_end) + n_bytes;
+
+    // map the file into memory; truncated file is detected before any data is read
+    const int fd = open(file_name.c_str(), O_RDONLY);
+    check_return(fd < 0, "File " + file_name + " cannot be opened!");
+    struct stat info;
+    const bool too_short = fstat(fd, &info) != 0 || (size_t)info.st_size < data_end;
+    void* mapping = too_short ? MAP_FAILED : mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    check_return(too_short, "Native mesh file " + file_name + " is truncated!");
+    check_return(mapping == MAP_FAILED, "Mapping of " + file_name + " failed!");
+
+    const char* data = (const char*)mapping;
+    size_t pos = in.tellg();
+    size_t block = 0;
+    auto next_block = [&]() {
+        pos = align(pos);
+        const char* ptr = data + pos;
+        pos += block_sizes[block++];
+        return ptr;
+    };
+    auto read_block = [&](void* dst) {
+        const size_t n_bytes = block_sizes[block];
+        memcpy(dst, next_block(), n_bytes);
+    };
+
+    clear();
+    GLOBALS.TIME = time;
+    GLOBALS.TIMESTEP = timestep;
+
+    vector<int> markers;
+    auto read_markers = [&](const int n_markers) {
+        markers.resize(n_markers);
+        read_block(markers.data());
+    };
+
+    // nodes
+    read_block(&nodes.indxs);
+    TetgenNodes::Stat node_stat;
+    read_block(&node_stat);
+    tetIOout.numberofpoints = n_nodes;
+    tetIOout.pointlist = new REAL[3 * n_nodes];
+    read_block(tetIOout.pointlist);
+    read_markers(n_nodes);
+    nodes.store_markers(markers);
+
+    // triangles
+    tetIOout.numberoftrifaces = n_tris;
+    tetIOout.trifacelist = new int[n_nodes_per_tri * n_tris];
+    read_block(tetIOout.trifacelist);
+    read_markers(n_tris);
+    tris.store_markers(markers);
+    tetIOout.face2tetlist = new int[n_tets_per_tri * n_tris];
+    read_block(tetIOout.face2tetlist);
+
+    // tetrahedra
+    tetIOout.numberoftetrahedra = n_tets;
+    tetIOout.tetrahedronlist = new int[n_nodes_per_tet * n_tets];
+    read_block(tetIOout.tetrahedronlist);
+    read_markers(n_tets);
+    tets.store_markers(markers);
+    tetIOout.neighborlist = new int[n_tris_per_tet * n_tets];
+    read_block(tetIOout.neighborlist);
+
+    // quadrangles
+    const SimpleQuad* quad_cells = (const SimpleQuad*)next_block();
+    quads.init(n_quads);
+    for (int i = 0; i < n_quads; ++i)
+        quads.append(quad_cells[i]);
+    read_markers(n_quads);
+    quads.store_markers(markers);
+
+    vector<array<int,2>> quad2hex(n_quads);
+    read_block(quad2hex.data());
+
+    // hexahedra
+    const SimpleHex* hex_cells = (const SimpleHex*)next_block();
+    hexs.init(n_hexs);
+    for (int i = 0; i < n_hexs; ++i)
+        hexs.append(hex_cells[i]);
+    read_markers(n_hexs);
+    hexs.store_markers(markers);
+
+    munmap(mapping, info.st_size);
+
+    for (int i = 0; i < n_nodes_per_tet * n_tets; ++i)
+        check_return(tetIOout.tetrahedronlist[i] < 0 || tetIOout.tetrahedronlist[i] >= n_nodes,
+                "Invalid node index in native mesh: " + d2s(tetIOout.tetrahedronlist[i]));
+    for (int i = 0; i < n_quads; ++i)
+        for (int hex : quad2hex[i])
+            check_return(hex >= n_hexs, "Invalid hexahedron index in native mesh: " + d2s(hex));
+
+    // restore the mappings between cells
+    vector<int> offsets, hex2quad;
+    invert_map(quad2hex, n_hexs, offsets, hex2quad);
+
+    quads.store_map(quad2hex);
+    hexs.store_map(offsets, hex2quad);
+    calc_tet2tri_mapping();
+
+    // restore the statistics
+    nodes.stat = node_stat;
+    tris.calc_statistics();
+    tets.calc_statistics();
+    tris.calc_appendices();
+
+    return 0;
+}
+
 void TetgenMesh::write_msh(ofstream &out) const {
     // write Gmsh header
     FileWriter::write_msh(out);
@@ -706,6 +1870,7 @@ void TetgenMesh::write_separate(const string& file_name, const int type) {
     tempmesh.nodes.copy(this->nodes);
     tempmesh.nodes.copy_markers(this->nodes);
     tempmesh.nodes.transfer();
+    tempmesh.compact();
     tempmesh.hexs.copy(this->hexs, hex_mask);
     tempmesh.hexs.copy_markers(this->hexs, hex_mask);
 
@@ -733,9 +1898,54 @@ void TetgenMesh::calc_pseudo_3D_vorocells(vector<vector<unsigned>>& cells, const
     }
 }
 
-bool TetgenMesh::calc_ranks(vector<int>& ranks, const vector<vector<unsigned>>& nborlist) {
+vector<int> TetgenMesh::flood_fill(const int seed, const vector<int>& offsets, const vector<int>& nbors,
+        vector<char>& visited, const vector<int>& ranks, const int min_rank) const
+{
+    vector<int> filled, frontier;
+
+    for (int i = offsets[seed]; i < offsets[seed+1]; ++i) {
+        const int node = nbors[i];
+        if (!visited[node]) {
+            visited[node] = 1;
+            frontier.push_back(node);
+        }
+    }
+
+    // expand the frontier layer by layer; the node is claimed by the thread that flags it first
+    while (frontier.size() > 0) {
+        filled.insert(filled.end(), frontier.begin(), frontier.end());
+        vector<int> next_frontier;
+
+#pragma omp parallel
+        {
+            vector<int> claimed;
+#pragma omp for nowait
+            for (int i = 0; i < (int) frontier.size(); ++i) {
+                const int node = frontier[i];
+                if (ranks[node] < min_rank) continue;
+
+                for (int j = offsets[node]; j < offsets[node+1]; ++j) {
+                    const int nbor = nbors[j];
+                    char was_visited;
+#pragma omp atomic capture
+                    { was_visited = visited[nbor]; visited[nbor] = 1; }
+                    if (!was_visited) claimed.push_back(nbor);
+                }
+            }
+#pragma omp critical
+            next_frontier.insert(next_frontier.end(), claimed.begin(), claimed.end());
+        }
+
+        frontier.swap(next_frontier);
+    }
+
+    return filled;
+}
+
+bool TetgenMesh::calc_ranks(vector<int>& ranks, const vector<int>& offsets, const vector<int>& nbors) {
     const int n_nbor_layers = 4;  // number of nearest tetrahedra whose nodes will act as a seed
     const int n_nodes = nodes.size();
+    const int seed = nodes.indxs.vacuum_start;
     const double max_rank = 100.0;
     const double eps = 0.01 * tets.stat.edgemin;
 
@@ -743,15 +1953,26 @@ bool TetgenMesh::calc_ranks(vector<int>& ranks, const vector<vector<unsigned>>&
     ranks = vector<int>(n_nodes);
 
     // distinguish the ranks of surface nodes
-    for (int i = nodes.indxs.surf_start; i <= nodes.indxs.surf_end; ++i)
+    vector<char> visited(n_nodes, 0);
+    for (int i = nodes.indxs.surf_start; i <= nodes.indxs.surf_end; ++i) {
         ranks[i] = -1;
+        visited[i] = 1;
+    }
 
-    // calculate the ranks from vacuum side
-    vector<unsigned> neighbours = nborlist[nodes.indxs.vacuum_start];
-    for (size_t i = 0; i < neighbours.size(); ++i) {
-        int node = neighbours[i];
-        if (ranks[node] != -1 && ranks[node]++ == 0)
-            neighbours.insert(neighbours.end(), nborlist[node].begin(), nborlist[node].end());
+    // find the nodes that are accessible from vacuum side without crossing the surface
+    flood_fill(seed, offsets, nbors, visited, ranks, 0);
+
+    // the rank of the node is the number of its connections with the accessible nodes and the seed
+#pragma omp parallel for
+    for (int node = 0; node < n_nodes; ++node) {
+        if (node >= nodes.indxs.surf_start && node <= nodes.indxs.surf_end) continue;
+        int rank = 0;
+        for (int j = offsets[node]; j < offsets[node+1]; ++j) {
+            const int nbor = nbors[j];
+            const bool surface = nbor >= nodes.indxs.surf_start && nbor <= nodes.indxs.surf_end;
+            rank += (nbor == seed) + (visited[nbor] && !surface);
+        }
+        ranks[node] = rank;
     }
 
     // normalise all the ranks with respect to the maximum rank
@@ -759,24 +1980,20 @@ bool TetgenMesh::calc_ranks(vector<int>& ranks, const vector<vector<unsigned>>&
     for (int& r : ranks)
         if (r > 0)
             r *= norm_factor;
-    
-    
-    // force the ranks around the vacuum seed region to the maximum value
 
-    vector<vector<unsigned>> nbors(n_nbor_layers);
-    ranks[nodes.indxs.vacuum_start] = max_rank;
-    for (int layer = 0; layer < n_nbor_layers; ++layer) {
-        // build next layer of node neighbour list
-        if (layer == 0)
-            nbors[0] = nborlist[nodes.indxs.vacuum_start];
-        else {
-            for (int nbor : nbors[layer-1])
-                if (ranks[nbor] > 0)
-                    nbors[layer].insert(nbors[layer].end(), nborlist[nbor].begin(), nborlist[nbor].end());
-        }
-        for (int nbor : nbors[layer])
-            if (ranks[nbor] > 0)
+    // force the ranks around the vacuum seed region to the maximum value
+    vector<int> layer(nbors.begin() + offsets[seed], nbors.begin() + offsets[seed+1]);
+    ranks[seed] = max_rank;
+    for (int l = 0; l < n_nbor_layers; ++l) {
+        vector<int> next_layer;
+        for (int nbor : layer)
+            if (ranks[nbor] > 0) {
                 ranks[nbor] = max_rank;
+                next_layer.insert(next_layer.end(), nbors.begin() + offsets[nbor], nbors.begin() + offsets[nbor+1]);
+            }
+        sort(next_layer.begin(), next_layer.end());
+        next_layer.erase(unique(next_layer.begin(), next_layer.end()), next_layer.end());
+        layer.swap(next_layer);
     }
 
     // force the ranks on the simubox vacuum perimeter to maximum value
@@ -803,12 +2020,12 @@ bool TetgenMesh::rank_and_mark_nodes() {
     int node;
 
     // Calculate neighbour list for nodes
-    vector<vector<unsigned>> nborlist;
-    tets.calc_nborlist(nborlist);
+    vector<int> offsets, nbors;
+    tets.calc_nborlist(offsets, nbors);
 
     // Calculate the ranks for the nodes to increase the robustness of the bulk-vacuum separator
     vector<int> ranks;
-    if ( !calc_ranks(ranks, nborlist) )
+    if ( !calc_ranks(ranks, offsets, nbors) )
         write_silent_msg("Surface has holes, therefore the mesh may or might not be valid!\n"
                 "Check the out/hexmesh_bulk.vtk and in case of problems, make sure \n"
                 "the radius is big enough and consider altering the coarsening factors!");
@@ -826,27 +2043,19 @@ bool TetgenMesh::rank_and_mark_nodes() {
     for (node = nodes.indxs.vacuum_start; node <= nodes.indxs.vacuum_end; ++node)
         nodes.set_marker(node, TYPES.VACUUM);
 
+    // nodes with known marker are not entered by the search
+    vector<char> visited(n_nodes);
+    for (node = 0; node < n_nodes; ++node)
+        visited[node] = nodes.get_marker(node) != TYPES.NONE;
+
     // Mark the vacuum nodes
-    vector<unsigned> neighbours = nborlist[nodes.indxs.vacuum_start];
-    for (size_t i = 0; i < neighbours.size(); ++i) {
-        node = neighbours[i];
-        if (nodes.get_marker(node) == TYPES.NONE) {
-            nodes.set_marker(node, TYPES.VACUUM);
-            if (ranks[node] >= min_rank)
-                neighbours.insert(neighbours.end(), nborlist[node].begin(), nborlist[node].end());
-        }
-    }
+    for (int n : flood_fill(nodes.indxs.vacuum_start, offsets, nbors, visited, ranks, min_rank))
+        nodes.set_marker(n, TYPES.VACUUM);
 
     // Mark the bulk nodes
     // no need to check the node ranks as vacuum nodes are all already marked
-    neighbours = nborlist[nodes.indxs.bulk_start];
-    for (size_t i = 0; i < neighbours.size(); ++i) {
-        node = neighbours[i];
-        if (nodes.get_marker(node) == TYPES.NONE) {
-            nodes.set_marker(node, TYPES.BULK);
-            neighbours.insert(neighbours.end(), nborlist[node].begin(), nborlist[node].end());
-        }
-    }
+    for (int n : flood_fill(nodes.indxs.bulk_start, offsets, nbors, visited, ranks, INT_MIN))
+        nodes.set_marker(n, TYPES.BULK);
 
     // Nodes inside the thin nanotip may not have nearest neighbour connection
     // with the rest of the bulk. Therefore mark them separately
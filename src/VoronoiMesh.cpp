@@ -263,16 +263,43 @@ void VoronoiMesh::calc_ranks(vector<int>& ranks, const int seedface) {
     // initialise all the ranks to 0
     ranks = vector<int>(n_faces);
 
-    // calculate the ranks from vacuum side
-    vector<int> neighbours = vfaces.get_neighbours(seedface);
-    for (size_t i = 0; i < neighbours.size(); ++i) {
-        int vface = neighbours[i];
-        if (vfaces.get_marker(vface) == TYPES.NONE && ranks[vface]++ == 0) {
-            vector<int> nbors = vfaces.get_neighbours(vface);
-            neighbours.insert(neighbours.end(), nbors.begin(),nbors.end());
+    // find the faces that are accessible from vacuum side;
+    // the face is claimed by the thread that flags it first, so it is expanded only once.
+    // The seed is not flagged, so if it is accessible, its neighbours are counted twice as before.
+    vector<char> visited(n_faces);
+    vector<int> accessible, frontier(1, seedface);
+    while (frontier.size() > 0) {
+        accessible.insert(accessible.end(), frontier.begin(), frontier.end());
+        vector<int> next_frontier;
+
+#pragma omp parallel
+        {
+            vector<int> claimed;
+#pragma omp for nowait
+            for (int i = 0; i < (int) frontier.size(); ++i)
+                for (int nbor : vfaces.get_neighbours(frontier[i])) {
+                    if (vfaces.get_marker(nbor) != TYPES.NONE) continue;
+                    char was_visited;
+#pragma omp atomic capture
+                    { was_visited = visited[nbor]; visited[nbor] = 1; }
+                    if (!was_visited) claimed.push_back(nbor);
+                }
+#pragma omp critical
+            next_frontier.insert(next_frontier.end(), claimed.begin(), claimed.end());
         }
+
+        frontier.swap(next_frontier);
     }
 
+    // calculate the ranks from vacuum side
+#pragma omp parallel for
+    for (int i = 0; i < (int) accessible.size(); ++i)
+        for (int nbor : vfaces.get_neighbours(accessible[i]))
+            if (vfaces.get_marker(nbor) == TYPES.NONE) {
+#pragma omp atomic
+                ranks[nbor]++;
+            }
+
     // normalise all the ranks with respect to the maximum rank
     double norm_factor = max_rank / *max_element(ranks.begin(), ranks.end());
     for (int& r : ranks)
@@ -332,21 +359,33 @@ void VoronoiMesh::mark_faces(const double zmin, const int seed) {
 //
 //    return;
 
-    // Mark the faces around the seed face
-    vector<int> neighbours = vfaces.get_neighbours(seed);
-    for (size_t i = 0; i < neighbours.size(); ++i) {
-        int face = neighbours[i];
-        if (vfaces.get_marker(face) == TYPES.NONE) {
-            vfaces.set_marker(face, TYPES.SURFACE);
-
-            // Expand the list of possible surface faces
-//            if (ranks[face] >= min_rank) {
-//                vector<int> nbors = vfaces.get_neighbours(face);
-//                neighbours.insert(neighbours.end(), nbors.begin(), nbors.end());
-//            }
-            vector<int> nbors = vfaces.get_neighbours(face);
-            neighbours.insert(neighbours.end(), nbors.begin(), nbors.end());
+    // Mark the faces around the seed face;
+    // the face is claimed by the thread that flags it first, so it is expanded only once
+    vector<char> visited(vfaces.size());
+    vector<int> frontier(1, seed);
+    while (frontier.size() > 0) {
+        vector<int> next_frontier;
+
+#pragma omp parallel
+        {
+            vector<int> claimed;
+#pragma omp for nowait
+            for (int i = 0; i < (int) frontier.size(); ++i)
+                for (int nbor : vfaces.get_neighbours(frontier[i])) {
+                    if (vfaces.get_marker(nbor) != TYPES.NONE) continue;
+                    char was_visited;
+#pragma omp atomic capture
+                    { was_visited = visited[nbor]; visited[nbor] = 1; }
+                    if (!was_visited) claimed.push_back(nbor);
+                }
+#pragma omp critical
+            next_frontier.insert(next_frontier.end(), claimed.begin(), claimed.end());
         }
+
+        // markers are changed outside the parallel region, as the threads read them
+        for (int face : next_frontier)
+            vfaces.set_marker(face, TYPES.SURFACE);
+        frontier.swap(next_frontier);
     }
 }
 
@@ -3609,6 +3609,15 @@ int tetgenmesh::sapexpivot[6] = {5, 5, 3, 3, 4, 4};
 ///////////////////////////////////////////////////////////////////////////////
 
 void tetgenmesh::inittables()
+{
+  // The tables are shared by all instances. Fill them only once, so that
+  //   concurrent tetrahedralize() calls don't write them simultaneously.
+  //   The initialization of local static is thread-safe. Added for FEMOCS.
+  static const bool filled = (filltables(), true);
+  (void) filled;
+}
+
+void tetgenmesh::filltables()
 {
   int soffset, toffset;
   int i, j;